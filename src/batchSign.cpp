@@ -0,0 +1,159 @@
+#include "batchSign.h"
+
+#if !defined(SIGN_128) && defined(__GNUC__) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_SIGN_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace signatureConstants;
+
+namespace batchSign {
+    static void mixScalar(const OperConstants& cst,
+            const sign_t* in, sign_t* out, size_t count)
+    {
+        for(size_t pos = 0; pos < count; ++pos)
+            out[pos] = cst(in[pos]);
+    }
+
+#ifdef BATCH_SIGN_AVX2
+    /// Low 64 bits of the lane-wise product `val * mul`
+    __attribute__((target("avx2")))
+    static inline __m256i mulLow64(__m256i val, __m256i mulLow,
+            __m256i mulHigh)
+    {
+        __m256i lowLow = _mm256_mul_epu32(val, mulLow);
+        __m256i cross = _mm256_add_epi64(
+                _mm256_mul_epu32(_mm256_srli_epi64(val, 32), mulLow),
+                _mm256_mul_epu32(val, mulHigh));
+        return _mm256_add_epi64(lowLow, _mm256_slli_epi64(cross, 32));
+    }
+
+    /** Lane-wise `val % mod`, for `val < 2**62` and `mod < 2**31`. The
+     * quotient is estimated with floating-point arithmetic (off by at most
+     * one), then the remainder is corrected with integer arithmetic. */
+    __attribute__((target("avx2")))
+    static inline __m256i modConst(__m256i val, __m256i mod, __m256d invMod)
+    {
+        // Adding 2**52 to an integer < 2**52 puts it in a double's mantissa
+        const __m256i magic = _mm256_set1_epi64x(0x4330000000000000ll);
+        const __m256d magicD = _mm256_castsi256_pd(magic);
+        const __m256i low32 = _mm256_set1_epi64x(0xffffffffll);
+
+        __m256d low = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(
+                        _mm256_and_si256(val, low32), magic)), magicD);
+        __m256d high = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(
+                        _mm256_srli_epi64(val, 32), magic)), magicD);
+        __m256d valD = _mm256_add_pd(
+                _mm256_mul_pd(high, _mm256_set1_pd(4294967296.)), low);
+
+        __m256d quotD = _mm256_floor_pd(_mm256_mul_pd(valD, invMod));
+        __m256i quot = _mm256_sub_epi64(
+                _mm256_castpd_si256(_mm256_add_pd(quotD, magicD)), magic);
+
+        __m256i prod = _mm256_add_epi64(
+                _mm256_mul_epu32(quot, mod),
+                _mm256_slli_epi64(_mm256_mul_epu32(
+                        _mm256_srli_epi64(quot, 32), mod), 32));
+        __m256i rem = _mm256_sub_epi64(val, prod);
+
+        __m256i negative = _mm256_cmpgt_epi64(_mm256_setzero_si256(), rem);
+        rem = _mm256_add_epi64(rem, _mm256_and_si256(negative, mod));
+        __m256i over = _mm256_cmpgt_epi64(rem,
+                _mm256_sub_epi64(mod, _mm256_set1_epi64x(1)));
+        return _mm256_sub_epi64(rem, _mm256_and_si256(over, mod));
+    }
+
+#ifdef SIGN_MIX_XORSHIFT
+    /// AVX2 version of `OperConstants::mix64`
+    __attribute__((target("avx2")))
+    static void mixAvx2(const OperConstants& cst,
+            const sign_t* in, sign_t* out, size_t count)
+    {
+        const __m256i add = _mm256_set1_epi64x(cst.add);
+        const __m256i mul1Low = _mm256_set1_epi64x(cst.mul1 & 0xffffffff);
+        const __m256i mul1High = _mm256_set1_epi64x(cst.mul1 >> 32);
+        const __m256i mul2Low = _mm256_set1_epi64x(cst.mul2 & 0xffffffff);
+        const __m256i mul2High = _mm256_set1_epi64x(cst.mul2 >> 32);
+
+        size_t pos = 0;
+        for(; pos + 4 <= count; pos += 4) {
+            __m256i val = _mm256_loadu_si256((const __m256i*)(in + pos));
+            val = _mm256_add_epi64(val, add);
+            val = _mm256_xor_si256(val, _mm256_srli_epi64(val, 32));
+            val = mulLow64(val, mul1Low, mul1High);
+            val = _mm256_xor_si256(val, _mm256_srli_epi64(val, 29));
+            val = mulLow64(val, mul2Low, mul2High);
+            val = _mm256_xor_si256(val, _mm256_srli_epi64(val, 32));
+            _mm256_storeu_si256((__m256i*)(out + pos), val);
+        }
+        mixScalar(cst, in + pos, out + pos, count - pos);
+    }
+#else
+    /// AVX2 version of `OperConstants::mix64`
+    __attribute__((target("avx2")))
+    static void mixAvx2(const OperConstants& cst,
+            const sign_t* in, sign_t* out, size_t count)
+    {
+        const __m256i low32 = _mm256_set1_epi64x(0xffffffffll);
+        const __m256i add = _mm256_set1_epi64x(cst.add);
+        const __m256i lowMul = _mm256_set1_epi64x(cst.lowMul);
+        const __m256i highMul = _mm256_set1_epi64x(cst.highMul);
+        const __m256i lowMod = _mm256_set1_epi64x(cst.lowMod);
+        const __m256i highMod = _mm256_set1_epi64x(cst.highMod);
+        const __m256d invLowMod = _mm256_set1_pd(1. / cst.lowMod);
+        const __m256d invHighMod = _mm256_set1_pd(1. / cst.highMod);
+
+        size_t pos = 0;
+        for(; pos + 4 <= count; pos += 4) {
+            __m256i val = _mm256_loadu_si256((const __m256i*)(in + pos));
+
+            // 32-bit wrapping additions, on the low half of each lane
+            __m256i lowIn = _mm256_and_si256(
+                    _mm256_add_epi32(val, add), low32);
+            __m256i out1 = _mm256_mul_epu32(lowIn, lowMul);
+
+            __m256i highIn = _mm256_xor_si256(
+                    _mm256_srli_epi64(val, 32), _mm256_srli_epi64(out1, 32));
+            highIn = _mm256_and_si256(_mm256_add_epi32(highIn, add), low32);
+            __m256i out2 = _mm256_and_si256(
+                    _mm256_mul_epu32(highIn, highMul), low32);
+
+            __m256i res = _mm256_or_si256(
+                    modConst(out1, lowMod, invLowMod),
+                    _mm256_slli_epi64(modConst(out2, highMod, invHighMod),
+                        32));
+            _mm256_storeu_si256((__m256i*)(out + pos), res);
+        }
+        mixScalar(cst, in + pos, out + pos, count - pos);
+    }
+#endif // SIGN_MIX_XORSHIFT
+
+    bool simdAvailable() {
+        static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+        return hasAvx2;
+    }
+#else
+    bool simdAvailable() {
+        return false;
+    }
+#endif // BATCH_SIGN_AVX2
+
+    static bool simdEnabled = true;
+
+    void setSimdEnabled(bool enabled) {
+        simdEnabled = enabled;
+    }
+
+    void mix(const OperConstants& cst,
+            const sign_t* in, sign_t* out, size_t count)
+    {
+#ifdef BATCH_SIGN_AVX2
+        if(simdEnabled && simdAvailable()) {
+            mixAvx2(cst, in, out, count);
+            return;
+        }
+#endif
+        mixScalar(cst, in, out, count);
+    }
+}
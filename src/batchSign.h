@@ -0,0 +1,26 @@
+/** Batched signature kernels.
+ *
+ * Applies a signature mixing function (`signatureConstants::OperConstants`)
+ * to many hashes at once, eg. the inner signature keys of all the leaf gates
+ * of a group. When the CPU supports it, this is done with AVX2 instructions,
+ * four signatures at a time; otherwise, a scalar loop is used. The choice is
+ * made at runtime. 128-bit signatures (`SIGN_128`) always use the scalar
+ * loop.
+ */
+
+#pragma once
+
+#include "signatureConstants.h"
+
+namespace batchSign {
+    /// Sets `out[i]` to `cst(in[i])` for every `i < count`
+    void mix(const signatureConstants::OperConstants& cst,
+            const sign_t* in, sign_t* out, size_t count);
+
+    /// Checks whether the SIMD kernels are available on this CPU
+    bool simdAvailable();
+
+    /** Enables or disables the SIMD kernels (if available), mostly for
+     * benchmarking and testing. Enabled by default. */
+    void setSimdEnabled(bool enabled);
+}
@@ -71,6 +71,19 @@ static ExpressionBase* exprOfHandle(expr_handle handle) {
     return out;
 }
 
+/** Hands `expr` to the caller, who owns a reference to it until
+ * `free_expression` is called on the returned handle */
+static expr_handle handleOfExpr(ExpressionBase* expr) {
+    expr->addRef();
+    return expr;
+}
+
+static SearchBudget* budgetOfHandle(budget_handle handle) {
+    if(handle == nullptr)
+        throw IsomError(ISOM_RC_NULLPTR);
+    return static_cast<SearchBudget*>(handle);
+}
+
 static WireId* wireOfHandle(wire_handle wire, CircuitGroup* context) {
     if(context == nullptr)
         throw IsomError(ISOM_RC_NO_PARENT);
@@ -356,7 +369,7 @@ circuit_handle build_tristate(circuit_handle parent,
 
 expr_handle build_expr_const(unsigned val) {
     try {
-        return new ExpressionConst(val);
+        return handleOfExpr(ExpressionConst::make(val));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
@@ -366,7 +379,7 @@ expr_handle build_expr_const(unsigned val) {
 expr_handle build_expr_longconst(const char* value) {
     try {
         try {
-            return new ExpressionLongConst(value);
+            return handleOfExpr(ExpressionLongConst::make(value));
         } catch(const BadHex&) {
             throw IsomError(ISOM_RC_BADHEX);
         }
@@ -378,7 +391,7 @@ expr_handle build_expr_longconst(const char* value) {
 
 expr_handle build_expr_var(int input_pin) {
     try {
-        return new ExpressionVar(input_pin);
+        return handleOfExpr(ExpressionVar::make(input_pin));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
@@ -390,10 +403,10 @@ expr_handle build_expr_binop(enum isom_expr_binop op,
         expr_handle right)
 {
     try {
-        return new ExpressionBinOp(
+        return handleOfExpr(ExpressionBinOp::make(
                 exprOfHandle(left),
                 exprOfHandle(right),
-                (expr::ExpressionBinOperator)op);
+                (expr::ExpressionBinOperator)op));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
@@ -402,9 +415,9 @@ expr_handle build_expr_binop(enum isom_expr_binop op,
 
 expr_handle build_expr_unop(enum isom_expr_unop op, expr_handle expr) {
     try {
-        return new ExpressionUnOp(
+        return handleOfExpr(ExpressionUnOp::make(
                 exprOfHandle(expr),
-                (expr::ExpressionUnOperator)op);
+                (expr::ExpressionUnOperator)op));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
@@ -416,10 +429,10 @@ expr_handle build_expr_unop_cst(enum isom_expr_unop_cst op,
         expr_handle expr)
 {
     try {
-        return new ExpressionUnOpCst(
+        return handleOfExpr(ExpressionUnOpCst::make(
                 exprOfHandle(expr),
                 param,
-                (expr::ExpressionUnOperatorCst)op);
+                (expr::ExpressionUnOperatorCst)op));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
@@ -428,7 +441,8 @@ expr_handle build_expr_unop_cst(enum isom_expr_unop_cst op,
 
 expr_handle build_expr_slice(expr_handle expr, unsigned beg, unsigned end) {
     try {
-        return new ExpressionSlice(exprOfHandle(expr), beg, end);
+        return handleOfExpr(
+                ExpressionSlice::make(exprOfHandle(expr), beg, end));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
@@ -437,7 +451,8 @@ expr_handle build_expr_slice(expr_handle expr, unsigned beg, unsigned end) {
 
 expr_handle build_expr_merge(expr_handle left, expr_handle right) {
     try {
-        return new ExpressionMerge(exprOfHandle(left), exprOfHandle(right));
+        return handleOfExpr(ExpressionMerge::make(
+                exprOfHandle(left), exprOfHandle(right)));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
@@ -446,7 +461,8 @@ expr_handle build_expr_merge(expr_handle left, expr_handle right) {
 
 int free_expression(expr_handle expr) {
     try {
-        delete exprOfHandle(expr);
+        // Expressions are shared: only release the handle's own reference
+        exprOfHandle(expr)->deleteSelf();
         return ISOM_RC_OK;
     } catch(const IsomError& e) {
         return handleError(e);
@@ -531,50 +547,169 @@ sign_t sign_with_precision(circuit_handle circuit, unsigned precision_level) {
     }
 }
 
+int isom_get_sig_stats(isom_sig_stats* stats) {
+    if(stats == nullptr) {
+        lastError = ISOM_RC_NULLPTR;
+        return lastError;
+    }
+    const sigStats::Counters& counters = sigStats::get();
+    stats->equal_checks = counters.equalChecks;
+    stats->equal_collisions = counters.equalCollisions;
+    stats->permutations_tried = counters.permutationsTried;
+    stats->permutations_failed = counters.permutationsFailed;
+    stats->match_checks = counters.matchChecks;
+    stats->match_collisions = counters.matchCollisions;
+    return ISOM_RC_OK;
+}
+
+void isom_reset_sig_stats() {
+    sigStats::reset();
+}
+
 // === Circuit matching
+/** Converts `res` to a `match_results` list, to be freed with
+ * `free_match_results` */
+static match_results* matchList(const std::vector<MatchResult>& res) {
+    match_results* outList = nullptr;
+
+    for(const auto& matchRes: res) {
+        match_results* cMatchLink = new match_results;
+        memset(cMatchLink, 0x00, sizeof(match_results));
+        single_match& cMatch = cMatchLink->match;
+        cMatchLink->next = outList;
+        outList = cMatchLink;
+
+        for(const auto& part: matchRes.parts) {
+            circuit_list* nLink = new circuit_list;
+            memset(nLink, 0x00, sizeof(circuit_list));
+            nLink->next = cMatch.parts;
+            cMatch.parts = nLink;
+            nLink->circ = part;
+        }
+        for(const auto& inWire: matchRes.inputs) {
+            wire_list* nLink = new wire_list;
+            memset(nLink, 0x00, sizeof(wire_list));
+            nLink->next = cMatch.inputs;
+            cMatch.inputs = nLink;
+            nLink->wire = inWire->name().c_str();
+        }
+        for(const auto& outWire: matchRes.outputs) {
+            wire_list* nLink = new wire_list;
+            memset(nLink, 0x00, sizeof(wire_list));
+            nLink->next = cMatch.outputs;
+            cMatch.outputs = nLink;
+            nLink->wire = outWire->name().c_str();
+        }
+    }
+    return outList;
+}
+
 match_results* subcircuit_find(circuit_handle needle, circuit_handle haystack){
     try {
-        std::vector<MatchResult> res = matchSubcircuit(
+        return matchList(matchSubcircuit(
                 circuitOfHandle<CircuitGroup>(needle),
-                circuitOfHandle<CircuitGroup>(haystack));
-        match_results* outList = nullptr;
-
-        for(const auto& matchRes: res) {
-            match_results* cMatchLink = new match_results;
-            memset(cMatchLink, 0x00, sizeof(match_results));
-            single_match& cMatch = cMatchLink->match;
-            cMatchLink->next = outList;
-            outList = cMatchLink;
-
-            for(const auto& part: matchRes.parts) {
-                circuit_list* nLink = new circuit_list;
-                memset(nLink, 0x00, sizeof(circuit_list));
-                nLink->next = cMatch.parts;
-                cMatch.parts = nLink;
-                nLink->circ = part;
-            }
-            for(const auto& inWire: matchRes.inputs) {
-                wire_list* nLink = new wire_list;
-                memset(nLink, 0x00, sizeof(wire_list));
-                nLink->next = cMatch.inputs;
-                cMatch.inputs = nLink;
-                nLink->wire = inWire->name().c_str();
-            }
-            for(const auto& outWire: matchRes.outputs) {
-                wire_list* nLink = new wire_list;
-                memset(nLink, 0x00, sizeof(wire_list));
-                nLink->next = cMatch.outputs;
-                cMatch.outputs = nLink;
-                nLink->wire = outWire->name().c_str();
-            }
+                circuitOfHandle<CircuitGroup>(haystack)));
+    } catch(const IsomError& e) {
+        handleError(e);
+        return nullptr;
+    }
+}
+
+match_results* subcircuit_find_scoped(circuit_handle needle,
+        circuit_handle haystack, circuit_list* roots, int max_depth,
+        isom_group_filter filter, void* filter_data)
+{
+    try {
+        MatchScope scope;
+        for(; roots != nullptr; roots = roots->next)
+            scope.roots.push_back(circuitOfHandle<CircuitGroup>(roots->circ));
+        scope.maxDepth = max_depth;
+        if(filter != nullptr) {
+            scope.filter = [filter, filter_data](CircuitGroup* group) {
+                return filter(group, filter_data) != 0;
+            };
         }
-        return outList;
+
+        return matchList(matchSubcircuit(
+                circuitOfHandle<CircuitGroup>(needle),
+                circuitOfHandle<CircuitGroup>(haystack),
+                scope));
     } catch(const IsomError& e) {
         handleError(e);
         return nullptr;
     }
 }
 
+// === Search budgets
+
+budget_handle isom_budget_new(unsigned time_ms, uint64_t max_nodes) {
+    return new SearchBudget(chrono::milliseconds(time_ms), max_nodes);
+}
+
+int isom_budget_cancel(budget_handle budget) {
+    try {
+        budgetOfHandle(budget)->cancel();
+        return ISOM_RC_OK;
+    } catch(const IsomError& e) {
+        return handleError(e);
+    }
+}
+
+int isom_budget_status(budget_handle budget) {
+    try {
+        switch(budgetOfHandle(budget)->status()) {
+            case SearchBudget::Status::COMPLETE:
+                return ISOM_SEARCH_COMPLETE;
+            case SearchBudget::Status::EXHAUSTED:
+                return ISOM_SEARCH_EXHAUSTED;
+            case SearchBudget::Status::CANCELLED:
+                return ISOM_SEARCH_CANCELLED;
+        }
+        throw IsomError(ISOM_RC_ERROR);
+    } catch(const IsomError& e) {
+        handleError(e);
+        return -1;
+    }
+}
+
+int isom_budget_free(budget_handle budget) {
+    try {
+        delete budgetOfHandle(budget);
+        return ISOM_RC_OK;
+    } catch(const IsomError& e) {
+        return handleError(e);
+    }
+}
+
+match_results* subcircuit_find_budgeted(circuit_handle needle,
+        circuit_handle haystack, budget_handle budget)
+{
+    try {
+        SearchBudget::Scope scope(*budgetOfHandle(budget));
+        return matchList(matchSubcircuit(
+                circuitOfHandle<CircuitGroup>(needle),
+                circuitOfHandle<CircuitGroup>(haystack)));
+    } catch(const IsomError& e) {
+        handleError(e);
+        return nullptr;
+    }
+}
+
+int isom_equals(circuit_handle fst, circuit_handle snd, budget_handle budget)
+{
+    try {
+        CircuitTree* fstCirc = circuitOfHandle(fst);
+        CircuitTree* sndCirc = circuitOfHandle(snd);
+        if(budget == nullptr)
+            return fstCirc->equals(sndCirc) ? 1 : 0;
+        SearchBudget::Scope scope(*budgetOfHandle(budget));
+        return fstCirc->equals(sndCirc) ? 1 : 0;
+    } catch(const IsomError& e) {
+        handleError(e);
+        return -1;
+    }
+}
+
 void free_circuit_list(circuit_list* list) {
     while(list != nullptr) {
         circuit_list* toDel = list;
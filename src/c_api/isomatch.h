@@ -23,9 +23,14 @@ extern "C" {
 /*****************************************************************************/
 /* Type declarations                                                         */
 /*****************************************************************************/
+#ifdef SIGN_128
+typedef unsigned __int128 sign_t; ///< Type of a circuit signature
+#else
 typedef uint64_t sign_t;         ///< Type of a circuit signature
+#endif
 typedef void* circuit_handle;   ///< Value representing a circuit
 typedef void* expr_handle;      ///< Value representing an expression
+typedef void* budget_handle;    ///< Value representing a search budget
 typedef const char* wire_handle;    ///< A wire name
 
 /// Linked list of `circuit_handle`
@@ -230,6 +235,12 @@ circuit_handle build_tristate(circuit_handle parent,
 /* Expressions */
 /***************/
 
+/* Structurally identical expressions share the same node. Each handle
+ * returned by a `build_expr_*` function nonetheless holds its own reference
+ * to its node, which the gates and expressions built from it do not take
+ * over: every such handle must eventually be released with
+ * `free_expression`, once it was used. */
+
 /// Build a constant expression node
 expr_handle build_expr_const(unsigned val);
 
@@ -260,7 +271,9 @@ expr_handle build_expr_slice(expr_handle expr, unsigned beg, unsigned end);
 /// Build a merge expression node
 expr_handle build_expr_merge(expr_handle left, expr_handle right);
 
-/// Free the given previously created expression
+/** Release the given handle, returned by a `build_expr_*` function. The
+ * expression is only freed once it is not used anymore by another handle,
+ * some gate or another expression. */
 int free_expression(expr_handle expr);
 
 /*****************************************************************************/
@@ -290,6 +303,25 @@ sign_t sign(circuit_handle circuit);
  * `precision_level` */
 sign_t sign_with_precision(circuit_handle circuit, unsigned precision_level);
 
+/** Signature collisions counters, see `sigStats.h`. These are only updated
+ * if the library was compiled with `SIG_STATS`. */
+typedef struct isom_sig_stats {
+    size_t equal_checks;        ///< Same-signature sub-equality checks
+    size_t equal_collisions;    ///< ... that were unequal
+    size_t permutations_tried;  ///< Permutations tried by group equality
+    size_t permutations_failed; ///< ... that failed
+    size_t match_checks;        ///< Candidate matches checked by find
+    size_t match_collisions;    ///< ... that were not actual matches
+} isom_sig_stats;
+
+/** Fills `stats` with the current signature collisions counters.
+ * @return 0 on success, > 0 on failure
+ */
+int isom_get_sig_stats(isom_sig_stats* stats);
+
+/// Resets the signature collisions counters
+void isom_reset_sig_stats();
+
 /*****************************************************************************/
 /* Circuit matching                                                          */
 /*****************************************************************************/
@@ -302,10 +334,71 @@ sign_t sign_with_precision(circuit_handle circuit, unsigned precision_level);
  */
 match_results* subcircuit_find(circuit_handle needle, circuit_handle haystack);
 
+/** Predicate over the groups searched by `subcircuit_find_scoped`, returning
+ * 0 to skip `group` along with its subgroups, non-zero to search it. */
+typedef int (*isom_group_filter)(circuit_handle group, void* data);
+
+/** Same as `subcircuit_find`, but only searches a part of the hierarchy of
+ * `haystack`:
+ *
+ * - the groups of `roots` and their subgroups, or the whole `haystack` if
+ *   `roots` is `NULL`;
+ * - at most `max_depth` levels below those, or without limit if negative;
+ * - only the groups accepted by `filter` if it is not `NULL`, which is then
+ *   passed `filter_data`.
+ */
+match_results* subcircuit_find_scoped(circuit_handle needle,
+        circuit_handle haystack, circuit_list* roots, int max_depth,
+        isom_group_filter filter, void* filter_data);
+
 /** Free a `match_results`. This *DOES NOT* free the `needle` and `haystack`
  * circuits used during the match! */
 void free_match_results(match_results* res);
 
+/*****************************************************************************/
+/* Search budgets                                                            */
+/*****************************************************************************/
+
+/** Outcome of the searches run within a budget, see `isom_budget_status` */
+typedef enum isom_search_status {
+    ISOM_SEARCH_COMPLETE = 0,  ///< The searches ran to their end
+    ISOM_SEARCH_EXHAUSTED = 1, ///< The budget ran out: the results are partial
+    ISOM_SEARCH_CANCELLED = 2, ///< Stopped by `isom_budget_cancel`: the
+                               ///< results are partial
+} isom_search_status;
+
+/** Creates a budget of `time_ms` milliseconds, counted from now, and of
+ * `max_nodes` search nodes, bounding the searches it is passed to. A zero
+ * value leaves the corresponding resource unbounded. The budget must be
+ * freed with `isom_budget_free`. */
+budget_handle isom_budget_new(unsigned time_ms, uint64_t max_nodes);
+
+/** Stops the searches running within `budget` at their next check. This may
+ * be called from another thread than the one searching.
+ * @return 0 on success, > 0 on failure
+ */
+int isom_budget_cancel(budget_handle budget);
+
+/** Returns the outcome of the searches run so far within `budget`, or -1 on
+ * error */
+int isom_budget_status(budget_handle budget);
+
+/** Frees a budget.
+ * @return 0 on success, > 0 on failure
+ */
+int isom_budget_free(budget_handle budget);
+
+/** Same as `subcircuit_find`, stopping early if `budget` runs out or is
+ * cancelled. The matches found until then are returned: check
+ * `isom_budget_status` to tell whether they are complete. */
+match_results* subcircuit_find_budgeted(circuit_handle needle,
+        circuit_handle haystack, budget_handle budget);
+
+/** Checks whether `fst` and `snd` are formally equal, within `budget` if it
+ * is not `NULL`. Returns 1 if they are, 0 if they are not or the budget ran
+ * out (see `isom_budget_status`), -1 on error. */
+int isom_equals(circuit_handle fst, circuit_handle snd, budget_handle budget);
+
 /*****************************************************************************/
 /* Mark and sweep                                                            */
 /*****************************************************************************/
@@ -1,5 +1,6 @@
 #include "circuitAssert.h"
 #include "signatureConstants.h"
+#include "leafStore.h"
 #include "dotPrint.h"
 
 #include <cassert>
@@ -7,19 +8,16 @@
 
 using namespace std;
 
-void CircuitAssert::InnerIoIter::operator++() {
-    ++ptr;
-}
-
 CircuitAssert::CircuitAssert(const std::string& name,
         ExpressionBase* expr) :
-    gateName(name), gateExpr(expr)
+    gateName(nameInterner::intern(name)), gateExpr(expr)
 {
     expr->addRef();
 }
 
 CircuitAssert::~CircuitAssert() {
     gateExpr->deleteSelf();
+    nameInterner::release(gateName);
 }
 
 void CircuitAssert::addInput(WireId* wire) {
@@ -27,10 +25,8 @@ void CircuitAssert::addInput(WireId* wire) {
     gateInputs.push_back(wire);
 }
 
-sign_t CircuitAssert::innerSignature() const {
-    return signatureConstants::opcst_leaftype(
-            ((circType() << 16) | (gateInputs.size() << 8))
-            + gateExpr->sign());
+sign_t CircuitAssert::innerSignatureKey() const {
+    return LeafStore::assertKey(gateInputs.size(), gateExpr);
 }
 
 bool CircuitAssert::innerEqual(CircuitTree* othTree) {
@@ -3,49 +3,11 @@
 #include <string>
 
 #include "circuitTree.h"
+#include "nameInterner.h"
 #include "gateExpression.h"
 
 class CircuitAssert : public CircuitTree {
-    protected:
-        // ========= I/O ITERATOR =============================================
-        class InnerIoIter : public CircuitTree::InnerIoIter {
-                typedef std::vector<WireId*>::const_iterator LowIter;
-                LowIter ptr;
-            public:
-                InnerIoIter(LowIter lowIter) : ptr(lowIter) {}
-                InnerIoIter(const InnerIoIter& it)
-                    : ptr(it.ptr) {}
-                virtual void operator++();
-                virtual WireId* operator*() { return *ptr; }
-                virtual InnerIoIter* clone() const {
-                    return new InnerIoIter(*this);
-                }
-
-            protected:
-                virtual bool equal(const CircuitTree::InnerIoIter& oth_) const
-                {
-                    const InnerIoIter& oth =
-                        static_cast<const InnerIoIter&>(oth_);
-                    return ptr == oth.ptr;
-                }
-        };
-
     public:
-        IoIter inp_begin() const {
-            return IoIter(
-                    new InnerIoIter(gateInputs.begin())
-                    );
-        }
-        IoIter out_begin() const {
-            return IoIter(
-                    new InnerIoIter(gateInputs.end())
-                    );
-        }
-        IoIter out_end() const {
-            return out_begin();
-        }
-        // ========= END I/O ITERATOR =========================================
-
         CircuitAssert(const std::string& name, ExpressionBase* expr);
 
         /** Deletes the gate's expression */
@@ -53,6 +15,12 @@ class CircuitAssert : public CircuitTree {
 
         CircType circType() const { return CIRC_ASSERT; }
 
+        WireSpan io_wires() const { return inp_wires(); }
+        WireSpan inp_wires() const {
+            return WireSpan(gateInputs.data(),
+                    gateInputs.data() + gateInputs.size());
+        }
+
         /// Adds `wire` as the next input for this gate.
         void addInput(WireId* wire);
 
@@ -63,7 +31,9 @@ class CircuitAssert : public CircuitTree {
         const ExpressionBase* expression() const { return gateExpr; }
 
         /** Get gate's name */
-        const std::string name() const { return gateName; }
+        const std::string& name() const {
+            return nameInterner::str(gateName);
+        }
 
         // Documentation in CircuitTree*
         size_t inputCount() const;
@@ -74,11 +44,11 @@ class CircuitAssert : public CircuitTree {
         void toDot(std::basic_ostream<char>& out, int indent=0);
 
     protected:
-        virtual sign_t innerSignature() const;
+        virtual sign_t innerSignatureKey() const;
         virtual bool innerEqual(CircuitTree* othTree);
 
     private:
-        std::string gateName;
+        name_id_t gateName;
         std::vector<WireId*> gateInputs;
         ExpressionBase* gateExpr;
 };
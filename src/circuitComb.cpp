@@ -1,26 +1,13 @@
 #include "circuitComb.h"
 #include "signatureConstants.h"
+#include "leafStore.h"
 #include "dotPrint.h"
 #include "debug.h"
 
 #include <cassert>
 using namespace std;
 
-CircuitComb::InnerIoIter::InnerIoIter(
-        const CircuitComb* circ, CircuitComb::InnerIoIter::LowIter lowIter)
-    : ptr(lowIter), circ(circ)
-{
-    if(ptr == circ->gateInputs.end())
-        ptr = circ->gateOutputs.begin();
-}
-
-void CircuitComb::InnerIoIter::operator++() {
-    ++ptr;
-    if(ptr == circ->gateInputs.end())
-        ptr = circ->gateOutputs.begin();
-}
-
-CircuitComb::CircuitComb()
+CircuitComb::CircuitComb() : gateInputCount(0)
 {}
 
 CircuitComb::~CircuitComb() {
@@ -30,34 +17,29 @@ CircuitComb::~CircuitComb() {
 
 void CircuitComb::addInput(WireId* input) {
     alter();
-    gateInputs.push_back(input);
+    gateWires.insert(gateWires.begin() + gateInputCount, input);
+    ++gateInputCount;
     input->connect(this);
 }
 
 void CircuitComb::addOutput(ExpressionBase* expr, WireId* wire) {
     alter();
-    gateOutputs.push_back(wire);
+    gateWires.push_back(wire);
     wire->connect(this);
     gateExprs.push_back(expr);
     expr->addRef();
 }
 
-sign_t CircuitComb::innerSignature() const {
-    sign_t exprsSum = 0;
-    for(auto expr : gateExprs)
-        exprsSum ^= expr->sign();
-
-    return signatureConstants::opcst_leaftype(
-            ((circType() << 16)
-             | (gateInputs.size() << 8)
-             | (gateOutputs.size()))
-            ^ exprsSum);
+sign_t CircuitComb::innerSignatureKey() const {
+    return LeafStore::combKey(gateInputCount,
+            gateWires.size() - gateInputCount,
+            gateExprs.data(), gateExprs.size());
 }
 
 bool CircuitComb::innerEqual(CircuitTree* othTree) {
     const CircuitComb* oth = dynamic_cast<const CircuitComb*>(othTree);
-    if(gateInputs.size() != oth->gateInputs.size()
-        || gateOutputs.size() != oth->gateOutputs.size()
+    if(gateInputCount != oth->gateInputCount
+        || gateWires.size() != oth->gateWires.size()
         || gateExprs.size() != oth->gateExprs.size())
     {
         EQ_DEBUG("Comb: mismatched sizes\n");
@@ -66,8 +48,8 @@ bool CircuitComb::innerEqual(CircuitTree* othTree) {
     for(size_t inp=0; inp < gateExprs.size(); ++inp) {
         if(!gateExprs[inp]->equals(*oth->gateExprs[inp])) {
             EQ_DEBUG("Comb: mismatched expressions (%s - %s)\n",
-                    gateOutputs[inp]->uniqueName().c_str(),
-                    oth->gateOutputs[inp]->uniqueName().c_str());
+                    nth_output(inp)->uniqueName().c_str(),
+                    oth->nth_output(inp)->uniqueName().c_str());
             return false;
         }
     }
@@ -75,23 +57,23 @@ bool CircuitComb::innerEqual(CircuitTree* othTree) {
 }
 
 size_t CircuitComb::inputCount() const {
-    return gateInputs.size();
+    return gateInputCount;
 }
 
 size_t CircuitComb::outputCount() const {
-    return gateOutputs.size();
+    return gateWires.size() - gateInputCount;
 }
 
 WireId* CircuitComb::nth_input(size_t circId) const {
     if(circId >= inputCount())
         return nullptr;
-    return gateInputs[circId];
+    return gateWires[circId];
 }
 
 WireId* CircuitComb::nth_output(size_t circId) const {
     if(circId >= outputCount())
         return nullptr;
-    return gateOutputs[circId];
+    return gateWires[gateInputCount + circId];
 }
 
 void CircuitComb::toDot(std::basic_ostream<char>& out, int indent) {
@@ -4,54 +4,21 @@
 #include "gateExpression.h"
 
 class CircuitComb : public CircuitTree {
-    protected:
-        // ========= I/O ITERATOR =============================================
-        class InnerIoIter : public CircuitTree::InnerIoIter {
-            public: typedef std::vector<WireId*>::const_iterator LowIter;
-            private:
-                LowIter ptr;
-                const CircuitComb* circ;
-            public:
-                InnerIoIter(const CircuitComb* circ, LowIter lowIter);
-                InnerIoIter(const InnerIoIter& it)
-                    : ptr(it.ptr), circ(it.circ) {}
-                virtual void operator++();
-                virtual WireId* operator*() { return *ptr; }
-                virtual InnerIoIter* clone() const {
-                    return new InnerIoIter(*this);
-                }
-            protected:
-                virtual bool equal(const CircuitTree::InnerIoIter& oth_) const
-                {
-                    const InnerIoIter& oth =
-                        static_cast<const InnerIoIter&>(oth_);
-                    return circ == oth.circ && ptr == oth.ptr;
-                }
-        };
-
     public:
-        IoIter inp_begin() const {
-            return IoIter(
-                    new InnerIoIter(this, gateInputs.begin())
-                    );
-        }
-        IoIter out_begin() const {
-            return IoIter(
-                    new InnerIoIter(this, gateOutputs.begin())
-                    );
-        }
-        IoIter out_end() const {
-            return IoIter(
-                    new InnerIoIter(this, gateOutputs.end())
-                    );
-        }
-        // ========= END I/O ITERATOR =========================================
-
         CircuitComb();
         virtual ~CircuitComb();
 
         CircType circType() const { return CIRC_COMB; }
 
+        WireSpan io_wires() const {
+            return WireSpan(gateWires.data(),
+                    gateWires.data() + gateWires.size());
+        }
+        WireSpan inp_wires() const {
+            return WireSpan(gateWires.data(),
+                    gateWires.data() + gateInputCount);
+        }
+
         /// Adds `wire` as the next input for this gate.
         void addInput(WireId* wire);
 
@@ -61,10 +28,10 @@ class CircuitComb : public CircuitTree {
         void addOutput(ExpressionBase* expr, WireId* wire);
 
         /** Gate's inputs */
-        const std::vector<WireId*>& inputs() const { return gateInputs; }
+        WireSpan inputs() const { return inp_wires(); }
 
         /** Gate's outputs */
-        const std::vector<WireId*>& outputs() const { return gateOutputs; }
+        WireSpan outputs() const { return out_wires(); }
 
         /** Gate's expressions */
         const std::vector<ExpressionBase*>& expressions() const {
@@ -80,11 +47,12 @@ class CircuitComb : public CircuitTree {
         void toDot(std::ostream& out, int indent=0);
 
     protected:
-        virtual sign_t innerSignature() const;
+        virtual sign_t innerSignatureKey() const;
         virtual bool innerEqual(CircuitTree* othTree);
 
     private:
-        std::vector<WireId*> gateInputs, gateOutputs;
+        std::vector<WireId*> gateWires; ///< Inputs, then outputs
+        size_t gateInputCount;
         std::vector<ExpressionBase*> gateExprs;
 };
 
@@ -1,5 +1,6 @@
 #include "circuitDelay.h"
 #include "signatureConstants.h"
+#include "leafStore.h"
 #include "dotPrint.h"
 
 #include <cassert>
@@ -7,24 +8,16 @@
 using namespace std;
 
 
-void CircuitDelay::InnerIoIter::operator++() {
-    if(ptr == circ->wireInput)
-        ptr = circ->wireOutput;
-    else if(ptr == circ->wireOutput)
-        ptr = nullptr;
-}
-
 CircuitDelay::CircuitDelay(WireId* from, WireId* to) :
-        wireInput(from), wireOutput(to)
+        wires{from, to}
 {
     assert(from != NULL && to != NULL);
     from->connect(this);
     to->connect(this);
 }
 
-sign_t CircuitDelay::innerSignature() const {
-    return signatureConstants::opcst_leaftype(
-            (circType() << 16) + (1 << 8) + 1);
+sign_t CircuitDelay::innerSignatureKey() const {
+    return LeafStore::wireGateKey(circType());
 }
 
 bool CircuitDelay::innerEqual(CircuitTree*) {
@@ -42,13 +35,13 @@ size_t CircuitDelay::outputCount() const {
 WireId* CircuitDelay::nth_input(size_t circId) const {
     if(circId >= inputCount())
         return nullptr;
-    return wireInput;
+    return wires[0];
 }
 
 WireId* CircuitDelay::nth_output(size_t circId) const {
     if(circId >= outputCount())
         return nullptr;
-    return wireOutput;
+    return wires[1];
 }
 
 void CircuitDelay::toDot(std::basic_ostream<char>& out, int indent) {
@@ -58,10 +51,10 @@ void CircuitDelay::toDot(std::basic_ostream<char>& out, int indent) {
         << thisCirc << " "
         << "[shape=triangle, rotate=90]" << '\n';
 
-    dotPrint::inWire(out, thisCirc, wireInput->uniqueName(),
+    dotPrint::inWire(out, thisCirc, wires[0]->uniqueName(),
             "headport=w");
     dotPrint::indent(out, indent);
-    dotPrint::outWire(out, thisCirc, wireOutput->uniqueName(),
+    dotPrint::outWire(out, thisCirc, wires[1]->uniqueName(),
             "headport=e");
 }
 
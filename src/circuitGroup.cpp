@@ -2,8 +2,10 @@
 #include "dotPrint.h"
 #include "signatureConstants.h"
 #include "groupEquality.h"
+#include "batchSign.h"
+#include "flatNetlist.h"
+#include "frozenCircuit.h"
 #include <cstdint>
-#include <unordered_map>
 #include <algorithm>
 
 #include "debug.h"
@@ -13,11 +15,12 @@ using namespace std;
 IOPin::IOPin(WireId* formal,
         WireId* actual,
         CircuitGroup* group) :
-    _formal(formal), _actual(actual), _group(group)
+    _formal(formal), _actual(actual), _group(group), _slot(0)
 {}
 
 IOPin::IOPin(std::string formalName, WireId* actual, CircuitGroup* group) :
-    _formal(NULL), _formalName(formalName), _actual(actual), _group(group)
+    _formal(NULL), _formalName(formalName), _actual(actual), _group(group),
+    _slot(0)
 {}
 
 void IOPin::connect(WireId* formal) {
@@ -25,38 +28,25 @@ void IOPin::connect(WireId* formal) {
         throw IOPin::AlreadyConnected();
     _formal = formal;
     link();
+    _group->alter(false); // The group's I/O wires changed
 }
 
 void IOPin::link() {
     _formal->connect(this, _actual);
 }
 
-void CircuitGroup::InnerIoIter::operator++() {
-    innerIncr();
-    nextValid(); // Forward to the next valid element.
-}
-
-void CircuitGroup::InnerIoIter::nextValid() {
-    while(ptr != circ->grpOutputs.end() && (*ptr)->formal() == nullptr)
-        innerIncr();
-}
-
-void CircuitGroup::InnerIoIter::innerIncr() {
-    if(ptr == circ->grpOutputs.end())
-        return;
-    ++ptr;
-    if(ptr == circ->grpInputs.end())
-        ptr = circ->grpOutputs.begin();
-}
-
 CircuitGroup::CircuitGroup(const std::string& name) :
-    CircuitTree(), name_(name), ioSigsTimestamp(0)
+    CircuitTree(), name_(nameInterner::intern(name)), removedChildren(0),
+    ioFormalInputs(0), ioFormalsTimestamp(0),
+    leafStoreTimestamp(0), netIndexTimestamp(0), ioSigsTimestamp(0)
 {
     wireManager_ = new WireManager();
 }
 
 CircuitGroup::CircuitGroup(const std::string& name, WireManager* manager) :
-    CircuitTree(), name_(name), wireManager_(manager), ioSigsTimestamp(0)
+    CircuitTree(), name_(nameInterner::intern(name)), wireManager_(manager),
+    removedChildren(0), ioFormalInputs(0), ioFormalsTimestamp(0),
+    leafStoreTimestamp(0), netIndexTimestamp(0), ioSigsTimestamp(0)
 {}
 
 CircuitGroup::~CircuitGroup() {
@@ -67,12 +57,14 @@ CircuitGroup::~CircuitGroup() {
     for(auto pin: grpOutputs)
         delete pin;
     delete wireManager_;
+    nameInterner::release(name_);
 }
 
 void CircuitGroup::addChild(CircuitTree* child) {
     alter();
 
     child->ancestor_ = this; // CircuitGroup is friend of CircuitTree
+    child->childPos = grpChildren.size();
     if(child->circType() == CIRC_GROUP) {
         CircuitGroup* grp = static_cast<CircuitGroup*>(child);
         for(auto inp : grp->getInputs()) {
@@ -115,9 +107,11 @@ void CircuitGroup::addOutput(const std::string& formal, WireId* actual) {
 
 std::vector<CircuitTree*>& CircuitGroup::getChildren() {
     alter();
+    compactChildren();
     return grpChildren;
 }
 const std::vector<CircuitTree*>& CircuitGroup::getChildren() const {
+    compactChildren();
     return grpChildren;
 }
 const std::vector<CircuitTree*>& CircuitGroup::getChildrenCst() const {
@@ -144,6 +138,27 @@ std::vector<MatchResult> CircuitGroup::find(CircuitGroup* needle) {
     return matchSubcircuit(needle, this);
 }
 
+std::vector<MatchResult> CircuitGroup::find(CircuitGroup* needle,
+        const MatchBindings& bindings)
+{
+    return matchSubcircuit(needle, this, bindings);
+}
+
+std::vector<MatchResult> CircuitGroup::find(CircuitGroup* needle,
+        const MatchScope& scope)
+{
+    return matchSubcircuit(needle, this, scope);
+}
+
+std::vector<MatchResult> CircuitGroup::findFlat(CircuitGroup* needle) {
+    FlatNetlist flat(this);
+    return flat.find(needle);
+}
+
+FrozenCircuit* CircuitGroup::freeze() {
+    return new FrozenCircuit(this);
+}
+
 size_t CircuitGroup::inputCount() const {
     return grpInputs.size();
 }
@@ -179,7 +194,7 @@ void CircuitGroup::unplug() {
 }
 
 void CircuitGroup::toDot(std::basic_ostream<char>& out, int indent) {
-    const string thisCirc = string("group_") + name_ + to_string(id());
+    const string thisCirc = string("group_") + name() + to_string(id());
 
     if(ancestor() == NULL) {
         // Root group
@@ -192,7 +207,7 @@ void CircuitGroup::toDot(std::basic_ostream<char>& out, int indent) {
     }
     indent += 2;
     dotPrint::indent(out, indent)
-        << "graph[style=filled, splines=curved, label=\"" << name_ << "\"]\n";
+        << "graph[style=filled, splines=curved, label=\"" << name() << "\"]\n";
 
     // Wires
     for(auto wire : wireManager()->wires()) {
@@ -226,7 +241,7 @@ void CircuitGroup::toDot(std::basic_ostream<char>& out, int indent) {
     }
 
     // Children
-    for(auto child : grpChildren)
+    for(auto child : getChildrenCst())
         child->toDot(out, indent);
 
     indent -= 2;
@@ -234,26 +249,85 @@ void CircuitGroup::toDot(std::basic_ostream<char>& out, int indent) {
         << "}\n";
 }
 
-sign_t CircuitGroup::ioSigOf(WireId* wire) {
-    try {
-        if(ioSigsTimestamp < lastAlterationTime)
-            computeIoSigs();
-        return ioSigs_.at(wire);
+void CircuitGroup::cacheIoFormals() const {
+    if(ioFormalsTimestamp >= lastAlterationTime)
+        return;
+
+    ioFormals.clear();
+    for(auto pin: grpInputs) {
+        if(pin->formal() != nullptr)
+            ioFormals.push_back(pin->formal());
     }
-    catch(const std::out_of_range& e) {
-        return 0;
+    ioFormalInputs = ioFormals.size();
+    for(auto pin: grpOutputs) {
+        if(pin->formal() != nullptr)
+            ioFormals.push_back(pin->formal());
     }
+    ioFormalsTimestamp = curHistoryTime;
 }
 
-sign_t CircuitGroup::innerSignature() const {
+const LeafStore& CircuitGroup::leafStore() const {
+    if(leafStoreTimestamp < lastAlterationTime) {
+        // The children may have been reordered through `getChildren`
+        compactChildren();
+        for(size_t pos = 0; pos < grpChildren.size(); ++pos)
+            grpChildren[pos]->childPos = pos;
+        leafStore_.build(grpChildren);
+        leafStoreTimestamp = curHistoryTime;
+    }
+    return leafStore_;
+}
+
+const NetIndex& CircuitGroup::netIndex() {
+    if(netIndexTimestamp < lastAlterationTime) {
+        netIndex_.build(this);
+        netIndexTimestamp = curHistoryTime;
+    }
+    return netIndex_;
+}
+
+void CircuitGroup::signChildren(int level) const {
+    // Level 0 of the leaves: gather their keys from the store, mix them at
+    // once
+    const LeafStore& store = leafStore();
+    vector<CircuitTree*> toSign;
+    vector<sign_t> keys;
+    for(size_t pos = 0; pos < store.size(); ++pos) {
+        CircuitTree* child = store.circuit(pos);
+        if(store.isLeaf(pos) && !child->isSignMemoized(0)) {
+            toSign.push_back(child);
+            keys.push_back(store.innerSignatureKey(pos));
+        }
+    }
+    vector<sign_t> sigs(keys.size());
+    batchSign::mix(signatureConstants::opcst_leaftype,
+            keys.data(), sigs.data(), keys.size());
+    for(size_t pos = 0; pos < toSign.size(); ++pos)
+        toSign[pos]->memoizeSign(0, sigs[pos]);
+
+    // Subgroups and higher levels
+    CircuitTree::signAll(getChildrenCst(), level);
+}
+
+sign_t CircuitGroup::ioSigOf(WireId* wire) {
+    if(ioSigsTimestamp < lastAlterationTime)
+        computeIoSigs();
+    if(wire->manager() != wireManager_ || wire->id() >= ioSigs_.size())
+        return 0;
+    return ioSigs_[wire->id()];
+}
+
+sign_t CircuitGroup::innerSignatureKey() const {
+    // Sign the children level by level, batching their inner signatures
+    signChildren();
+
     sign_t subsigs = 0;
-    for(auto sub : grpChildren)
+    for(auto sub : getChildrenCst())
         subsigs += sub->sign();
-    return signatureConstants::opcst_leaftype(
-            ((circType() << 16)
-             | (grpInputs.size() << 8)
-             | (grpOutputs.size()))
-            + subsigs);
+    return ((circType() << 16)
+            | (grpInputs.size() << 8)
+            | (grpOutputs.size()))
+        + subsigs;
 }
 
 bool CircuitGroup::innerEqual(CircuitTree* othTree) {
@@ -268,52 +342,87 @@ static uint64_t expmod(uint64_t base, uint64_t exp, uint64_t mod) {
     return (mod & 1) ? ((out * base) % mod) : out;
 }
 
-/** Computes the I/O signature of a single wire, given the I/O pins it is
- * connected to. */
-static sign_t ioSigOfSet(const unordered_set<size_t>& set) {
-    static const uint32_t pinMod = signatureConstants::pinIdMod;
-    auto valSig = [](size_t val) { return expmod(2, val, pinMod); };
+/** Get the signature of the `pin`-th I/O pin of a group. The signatures of
+ * the first pins are tabulated once and for all, and shared by all the
+ * groups: this is thread-safe. */
+static sign_t pinSig(size_t pin) {
+    static const size_t TABULATED_PINS = 4096;
+    static const vector<sign_t> table = [] {
+        vector<sign_t> out(TABULATED_PINS);
+        for(size_t pos = 0; pos < out.size(); ++pos)
+            out[pos] = expmod(2, pos, signatureConstants::pinIdMod);
+        return out;
+    }();
 
-    sign_t out = 0;
-    for(auto& val : set)
-        out = (out + valSig(val)) % pinMod;
-    return out;
+    if(pin < table.size())
+        return table[pin];
+    return expmod(2, pin, signatureConstants::pinIdMod);
 }
 
 void CircuitGroup::computeIoSigs() {
-    unordered_map<WireId*, unordered_set<size_t> > inpPinsForWire;
-    unordered_map<WireId*, unordered_set<size_t> > outPinsForWire;
+    static const sign_t pinMod = signatureConstants::pinIdMod;
 
+    // The inputs' signature lies in the low 32 bits, the outputs' in the
+    // high bits.
+    ioSigs_.assign(wireManager_->allWires().size(), 0);
+    ioSigsTimestamp = curHistoryTime;
     for(size_t inpId = 0; inpId < grpInputs.size(); ++inpId) {
-        IOPin* pin = grpInputs[inpId];
-        auto& wireSet = inpPinsForWire[pin->actual()];
-        wireSet.insert(inpId);
+        WireId* wire = grpInputs[inpId]->actual();
+        if(wire->manager() != wireManager_)
+            continue;
+        sign_t& sig = ioSigs_[wire->id()];
+        sig = (sig + pinSig(inpId)) % pinMod;
     }
     for(size_t outId = 0; outId < grpOutputs.size(); ++outId) {
-        IOPin* pin = grpOutputs[outId];
-        auto& wireSet = outPinsForWire[pin->actual()];
-        wireSet.insert(outId);
+        WireId* wire = grpOutputs[outId]->actual();
+        if(wire->manager() != wireManager_)
+            continue;
+        sign_t& sig = ioSigs_[wire->id()];
+        sign_t outSig = ((sig >> 32) + pinSig(outId)) % pinMod;
+        sig = (sig & 0xffffffff) | (outSig << 32);
     }
-
-    ioSigs_.clear();
-    ioSigsTimestamp = curHistoryTime;
-    for(auto& entry : inpPinsForWire)
-        ioSigs_[entry.first] = ioSigOfSet(entry.second);
-    for(auto& entry : outPinsForWire)
-        ioSigs_[entry.first] += (ioSigOfSet(entry.second) << 32);
     // FIXME ough to mix up a bit the two parts.
+
+#ifdef SIGN_128
+    // Spread the I/O signatures over the whole 128 bits
+    for(auto& sig: ioSigs_) {
+        if(sig != 0)
+            sig = signatureConstants::opcst_groupIO(sig);
+    }
+#endif
 }
 
 void CircuitGroup::alteredChild() {
     CircuitTree::alter();
-    for(auto& child: grpChildren)
-        child->alter(false);
+    // Invalidates the signatures of every child, see `isSignMemoized`
+    lastChildAlterationTime = curHistoryTime;
 }
 
 void CircuitGroup::disconnectChild(CircuitTree* toRemove) {
-    auto iter = std::find(grpChildren.begin(), grpChildren.end(), toRemove);
-    if(iter == grpChildren.end()) {
-        throw NoSuchChild();
+    size_t pos = toRemove->childPos;
+    if(pos >= grpChildren.size() || grpChildren[pos] != toRemove) {
+        // The children were reordered through `getChildren`
+        auto iter = std::find(grpChildren.begin(), grpChildren.end(),
+                toRemove);
+        if(iter == grpChildren.end()) {
+            throw NoSuchChild();
+        }
+        pos = iter - grpChildren.begin();
+    }
+    grpChildren[pos] = nullptr;
+    ++removedChildren;
+}
+
+void CircuitGroup::compactChildren() const {
+    if(removedChildren == 0)
+        return;
+    size_t kept = 0;
+    for(auto child: grpChildren) {
+        if(child == nullptr)
+            continue;
+        child->childPos = kept;
+        grpChildren[kept++] = child;
     }
-    grpChildren.erase(iter);
+    grpChildren.resize(kept);
+    removedChildren = 0;
 }
@@ -6,9 +6,12 @@
 #include "wireId.h"
 #include "wireManager.h"
 #include "circuitTree.h"
+#include "leafStore.h"
+#include "netIndex.h"
 #include "subcircMatch.h"
 
 class CircuitGroup;
+class FrozenCircuit;
 
 /** Input/output pin for a `CircuitGroup` */
 class IOPin {
@@ -39,61 +42,15 @@ class IOPin {
         std::string _formalName; /// Used if formal is not yet connected
         WireId* _actual;
         CircuitGroup* _group;
+        size_t _slot; ///< Position in the formal wire's connected pins
 
         friend CircuitGroup;
+        friend WireManager;
 };
 
 
 class CircuitGroup : public CircuitTree {
-    protected:
-        // ========= I/O ITERATOR =============================================
-        class InnerIoIter : public CircuitTree::InnerIoIter {
-                typedef std::vector<IOPin*>::const_iterator LowIter;
-                LowIter ptr;
-                const CircuitGroup* circ;
-            public:
-                InnerIoIter(const CircuitGroup* circ, LowIter lowIter)
-                    : ptr(lowIter), circ(circ)
-                {
-                    nextValid();
-                }
-                InnerIoIter(const InnerIoIter& it)
-                    : ptr(it.ptr) {}
-                virtual void operator++();
-                virtual WireId* operator*() { return (*ptr)->formal(); }
-                virtual InnerIoIter* clone() const {
-                    return new InnerIoIter(*this);
-                }
-            protected:
-                virtual bool equal(const CircuitTree::InnerIoIter& oth_) const
-                {
-                    const InnerIoIter& oth =
-                        static_cast<const InnerIoIter&>(oth_);
-                    return ptr == oth.ptr && circ == oth.circ;
-                }
-            private:
-                void nextValid();
-                void innerIncr();
-        };
-
     public:
-        IoIter inp_begin() const {
-            return IoIter(
-                    new InnerIoIter(this, grpInputs.begin())
-                    );
-        }
-        IoIter out_begin() const {
-            return IoIter(
-                    new InnerIoIter(this, grpOutputs.begin())
-                    );
-        }
-        IoIter out_end() const {
-            return IoIter(
-                    new InnerIoIter(this, grpOutputs.end())
-                    );
-        }
-        // ========= END I/O ITERATOR =========================================
-
         /** Create a `CircuitGroup` with a given `name`. Its internal
          * `WireManager` is automatically created.
          */
@@ -112,6 +69,17 @@ class CircuitGroup : public CircuitTree {
 
         CircType circType() const { return CIRC_GROUP; }
 
+        WireSpan io_wires() const {
+            cacheIoFormals();
+            return WireSpan(ioFormals.data(),
+                    ioFormals.data() + ioFormals.size());
+        }
+        WireSpan inp_wires() const {
+            cacheIoFormals();
+            return WireSpan(ioFormals.data(),
+                    ioFormals.data() + ioFormalInputs);
+        }
+
         /**
          * Adds `child` as a child of this group. All external pins of `child`
          * are disconnected, and reconnected to this group's corresponding
@@ -140,7 +108,9 @@ class CircuitGroup : public CircuitTree {
         void addOutput(const std::string& formal, WireId* actual);
 
         /**
-         * Group's subcircuits, mutable.
+         * Group's subcircuits, mutable. The children may be reordered,
+         * added or removed; their `childIndex` is updated along with the
+         * `leafStore`.
          */
         std::vector<CircuitTree*>& getChildren();
         /**
@@ -163,6 +133,21 @@ class CircuitGroup : public CircuitTree {
         /** Group's outputs */
         const std::vector<IOPin*>& getOutputs() const;
 
+        /** Get the compact store of this group's children, rebuilt (along
+         * with their `childIndex`) if the group was altered since its last
+         * use. */
+        const LeafStore& leafStore() const;
+
+        /** Get the flat index of the nets of the hierarchy rooted at this
+         * group, rebuilt if the hierarchy was altered since its last use.
+         * Renaming (thus merging) wires does not alter the hierarchy: alter
+         * the affected groups afterwards. */
+        const NetIndex& netIndex();
+
+        /** Signs all the children of this group at `level`, computing the
+         * level-0 signatures of the leaves from the `leafStore`. */
+        void signChildren(int level=2) const;
+
         /** Returns the I/O signature of a belonging to this group, that is, a
          * signature encompassing how this particular wire is connected to the
          * I/O pins of this group.
@@ -174,6 +159,9 @@ class CircuitGroup : public CircuitTree {
         // Note: this cannot be `const`, since the `wireManager_` is muted
         // whenever one tries to allocate a wire.
 
+        /// Read-only access to the group's `WireManager`
+        const WireManager* wireManager() const { return wireManager_; }
+
         /** Returns every match of `needle` found (recursively in the
          * hierarchy) in this group. Two results will never be overlapping; if
          * two overlapping subcircuits are matches, it is undefined which one
@@ -181,8 +169,31 @@ class CircuitGroup : public CircuitTree {
          */
         std::vector<MatchResult> find(CircuitGroup* needle);
 
+        /** Same as `find`, but returns only the matches conforming to
+         * `bindings`, eg. attached to a given wire. See `matchSubcircuit`.
+         */
+        std::vector<MatchResult> find(CircuitGroup* needle,
+                const MatchBindings& bindings);
+
+        /** Same as `find`, but searches only the groups of the hierarchy
+         * within `scope`. See `matchSubcircuit`. */
+        std::vector<MatchResult> find(CircuitGroup* needle,
+                const MatchScope& scope);
+
+        /** Same as `find`, but on the flattened hierarchy, finding the
+         * matches spanning across group boundaries as well. See
+         * `FlatNetlist::find`. */
+        std::vector<MatchResult> findFlat(CircuitGroup* needle);
+
+        /** Builds an immutable snapshot of the hierarchy rooted at this
+         * group, which can be queried from several threads at once. See
+         * `FrozenCircuit`. The snapshot is owned by the caller. */
+        FrozenCircuit* freeze();
+
         /// Get the group's name
-        const std::string& name() const { return name_; }
+        const std::string& name() const {
+            return nameInterner::str(name_);
+        }
 
         // Documentation in CircuitTree*
         size_t inputCount() const;
@@ -197,29 +208,52 @@ class CircuitGroup : public CircuitTree {
     protected:
         void alteredChild();
 
-        virtual sign_t innerSignature() const;
+        virtual sign_t innerSignatureKey() const;
         virtual bool innerEqual(CircuitTree* othTree);
         void computeIoSigs();
 
+        /// Fills `ioFormals` if it is outdated
+        void cacheIoFormals() const;
+
     private:
         /// Thrown by `disconnectChild`
         class NoSuchChild: public std::exception {};
 
         void setAncestor(CircuitTree* tree) const;
 
-        /** Removes the given circuit from this group's children. Trusts the
-         * caller with calling `alter`. */
+        /** Removes the given circuit from this group's children, in
+         * constant time: it leaves a tombstone, removed by the next
+         * `compactChildren`. Trusts the caller with calling `alter`. */
         void disconnectChild(CircuitTree* toRemove);
 
-        std::string name_;
+        /** Removes the tombstones left by `disconnectChild` from
+         * `grpChildren`, keeping the children's order */
+        void compactChildren() const;
+
+        name_id_t name_;
 
         WireManager* wireManager_;
 
-        std::vector<CircuitTree*> grpChildren;
+        /// Children, and `nullptr` tombstones (see `disconnectChild`)
+        mutable std::vector<CircuitTree*> grpChildren;
+        mutable size_t removedChildren; ///< Tombstones in `grpChildren`
         std::vector<IOPin*> grpInputs, grpOutputs;
 
+        /** Connected formal wires of the input pins, then of the output
+         * pins, cached for `io_wires` */
+        mutable std::vector<WireId*> ioFormals;
+        mutable size_t ioFormalInputs;
+        mutable memo_ts_t ioFormalsTimestamp;
+
+        mutable LeafStore leafStore_;
+        mutable memo_ts_t leafStoreTimestamp;
+
+        NetIndex netIndex_;
+        memo_ts_t netIndexTimestamp;
+
         memo_ts_t ioSigsTimestamp;
-        std::unordered_map<WireId*, sign_t> ioSigs_;
+        /// I/O signatures of the wires, indexed by wire id
+        std::vector<sign_t> ioSigs_;
 
     friend class CircuitTree;
 };
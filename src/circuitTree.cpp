@@ -1,15 +1,22 @@
 #include "circuitTree.h"
 #include "circuitGroup.h"
+#include "circuitComb.h"
+#include "circuitDelay.h"
+#include "circuitTristate.h"
+#include "circuitAssert.h"
+#include "batchSign.h"
 #include "debug.h"
 #include <cassert>
 
 using namespace std;
 
 size_t CircuitTree::nextCircuitId = 0;
+CircuitTree::memo_ts_t CircuitTree::historyClock = 1;
 
 CircuitTree::CircuitTree() :
         curHistoryTime(1), lastAlterationTime(1), // 1: nothing memoized yet
-        ancestor_(NULL), circuitId(nextCircuitId)
+        lastChildAlterationTime(0),
+        ancestor_(NULL), circuitId(nextCircuitId), childPos(0)
 {
     nextCircuitId++;
 }
@@ -18,44 +25,96 @@ CircuitTree::~CircuitTree()
 {}
 
 sign_t CircuitTree::sign(int level) {
-    if(level < (int)memoSig.size()
-            && memoSig[level].timestamp >= lastAlterationTime)
+    if(isSignMemoized(level))
         return memoSig[level].sig;
 
     sign_t signature = computeSignature(level);
-    while((int)memoSig.size() <= level) // Create [level] cell
-        memoSig.push_back(MemoSign(0, 0)); // 0 is always invalid
-    memoSig[level] = MemoSign(curHistoryTime, signature);
+    memoizeSign(level, signature);
     return signature;
 }
 
+void CircuitTree::signAll(const std::vector<CircuitTree*>& circs, int level) {
+    // Level 0: gather the keys of the gates not yet signed, mix them at once
+    vector<CircuitTree*> toSign;
+    vector<sign_t> keys;
+    for(auto circ: circs) {
+        if(!circ->isSignMemoized(0)) {
+            toSign.push_back(circ);
+            keys.push_back(circ->innerSignatureKey());
+        }
+    }
+    vector<sign_t> sigs(keys.size());
+    batchSign::mix(signatureConstants::opcst_leaftype,
+            keys.data(), sigs.data(), keys.size());
+    for(size_t pos = 0; pos < toSign.size(); ++pos)
+        toSign[pos]->memoizeSign(0, sigs[pos]);
+
+    for(int curLevel = 1; curLevel <= level; ++curLevel) {
+        for(auto circ: circs)
+            circ->sign(curLevel);
+    }
+}
+
 bool CircuitTree::equals(CircuitTree* oth) {
     if(circType() != oth->circType())
         return false;
     return innerEqual(oth);
 }
 
+CircuitTree* CircuitTree::copyLeaf(const CircuitTree* leaf,
+        WireId* const* wires)
+{
+    switch(leaf->circType()) {
+        case CIRC_COMB: {
+            const CircuitComb* comb = static_cast<const CircuitComb*>(leaf);
+            CircuitComb* copy = new CircuitComb();
+            size_t inputs = comb->inputCount();
+            for(size_t inp = 0; inp < inputs; ++inp)
+                copy->addInput(wires[inp]);
+            for(size_t out = 0; out < comb->outputCount(); ++out)
+                copy->addOutput(comb->expressions()[out],
+                        wires[inputs + out]);
+            return copy;
+        }
+        case CIRC_DELAY:
+            return new CircuitDelay(wires[0], wires[1]);
+        case CIRC_TRI: // Input, enable, output
+            return new CircuitTristate(wires[0], wires[2], wires[1]);
+        case CIRC_ASSERT: {
+            const CircuitAssert* assertion =
+                static_cast<const CircuitAssert*>(leaf);
+            CircuitAssert* copy = new CircuitAssert(assertion->name(),
+                    const_cast<ExpressionBase*>(assertion->expression()));
+            for(size_t inp = 0; inp < assertion->inputCount(); ++inp)
+                copy->addInput(wires[inp]);
+            return copy;
+        }
+        case CIRC_GROUP:
+            break;
+    }
+    return nullptr;
+}
+
 void CircuitTree::unplug() {
     unplug_common();
 
-    for(auto conn = io_begin(); conn != io_end(); ++conn) {
-        (*conn)->disconnect(this);
-    }
+    for(auto wire: io_wires())
+        wire->disconnect(this);
 }
 
 sign_t CircuitTree::computeSignature(int level) {
-    // Depends only on the gate's type and contents.
-    sign_t inner = innerSignature();
-
     if(level <= 0)
-        return inner;
+        return innerSignature();
+
+    // Depends only on the gate's type and contents.
+    sign_t inner = sign(0);
 
     // inpSig is the sum of the signatures of order `level - 1` of all
     // directly input-adjacent gates.
     sign_t inpSig = 0;
-    for(auto wire = inp_begin(); wire != inp_end(); ++wire) {
-        for(auto circ = (*wire)->adjacent_begin();
-                circ != (*wire)->adjacent_end(); ++circ)
+    for(auto wire: inp_wires()) {
+        for(auto circ = wire->adjacent_begin();
+                circ != wire->adjacent_end(); ++circ)
         {
             inpSig += (*circ)->sign(level-1);
         }
@@ -63,9 +122,9 @@ sign_t CircuitTree::computeSignature(int level) {
 
     // Idem with output-adjacent gates
     sign_t outSig = 0;
-    for(auto wire = out_begin(); wire != out_end(); ++wire) {
-        for(auto circ = (*wire)->adjacent_begin();
-                circ != (*wire)->adjacent_end(); ++circ)
+    for(auto wire: out_wires()) {
+        for(auto circ = wire->adjacent_begin();
+                circ != wire->adjacent_end(); ++circ)
         {
             outSig += (*circ)->sign(level-1);
         }
@@ -75,13 +134,32 @@ sign_t CircuitTree::computeSignature(int level) {
     // what's an IO signature, see `CircuitGroup::ioSigOf`'s docstring.
     sign_t ioSig = 0;
     if(ancestor_ != nullptr) {
-        for(auto wire = io_begin(); wire != io_end(); ++wire)
-            ioSig += ancestor_->ioSigOf(*wire);
+        for(auto wire: io_wires())
+            ioSig += ancestor_->ioSigOf(wire);
     }
 
     return inner + ioSig + inpSig - outSig;
 }
 
+sign_t CircuitTree::innerSignature() const {
+    return signatureConstants::opcst_leaftype(innerSignatureKey());
+}
+
+bool CircuitTree::isSignMemoized(int level) const {
+    if(level >= (int)memoSig.size())
+        return false;
+    memo_ts_t timestamp = memoSig[level].timestamp;
+    return timestamp >= lastAlterationTime
+        && (ancestor_ == nullptr
+                || timestamp >= ancestor_->lastChildAlterationTime);
+}
+
+void CircuitTree::memoizeSign(int level, sign_t signature) {
+    while((int)memoSig.size() <= level) // Create [level] cell
+        memoSig.push_back(MemoSign(0, 0)); // 0 is always invalid
+    memoSig[level] = MemoSign(historyClock, signature);
+}
+
 void CircuitTree::unplug_common() {
     alter();
     if(ancestor_ != nullptr)
@@ -90,7 +168,7 @@ void CircuitTree::unplug_common() {
 }
 
 void CircuitTree::alter(bool uprec) {
-    curHistoryTime++;
+    curHistoryTime = ++historyClock;
     lastAlterationTime = curHistoryTime;
     if(uprec && ancestor_ != nullptr)
         ancestor_->alteredChild();
@@ -1,41 +1,31 @@
 #pragma once
 #include <exception>
 #include <ostream>
-#include <iterator>
-#include <typeinfo>
+#include <vector>
 
 #include "signatureConstants.h"
 #include "wireId.h"
 
-class CircuitTree {
-    protected:
-        /** Inner `ConstIoIter`, to be reimplemented in derived classes. */
-        class InnerIoIter :
-            public std::iterator<std::forward_iterator_tag, WireId*>
-        {
-            public:
-                virtual ~InnerIoIter() {};
-                virtual void operator++() {};
-                bool operator==(InnerIoIter& oth) {
-                    return typeid(*this) == typeid(oth) && equal(oth);
-                }
-                bool operator!=(InnerIoIter& oth) {
-                    return !(operator==(oth));
-                }
-                virtual WireId* operator*() { return nullptr; }
-                virtual InnerIoIter* clone() const {
-                    return new InnerIoIter(*this);
-                }
-            protected:
-                /** Checks for equality with its parameter. It can be assumed
-                 * that this parameter is of the same type as `*this`, even in
-                 * subclassed iterators.
-                 */
-                virtual bool equal(const InnerIoIter&) const {
-                    return true;
-                }
-        };
+/** Contiguous, non-owning range of wires, eg. the inputs of a gate. It is
+ * invalidated when the gate it comes from is altered. */
+class WireSpan {
+    public:
+        typedef WireId* const* iterator;
 
+        WireSpan() : begin_(nullptr), end_(nullptr) {}
+        WireSpan(iterator begin, iterator end) : begin_(begin), end_(end) {}
+
+        iterator begin() const { return begin_; }
+        iterator end() const { return end_; }
+        size_t size() const { return end_ - begin_; }
+        bool empty() const { return begin_ == end_; }
+        WireId* operator[](size_t pos) const { return begin_[pos]; }
+
+    private:
+        iterator begin_, end_;
+};
+
+class CircuitTree {
     public:
         enum CircType {
             CIRC_GROUP,
@@ -46,42 +36,7 @@ class CircuitTree {
         };
 
         /** Iterator over the WireIds of the diverse circuit gates */
-        class IoIter {
-            public:
-                IoIter() : inner(nullptr) {}
-                IoIter(InnerIoIter* ptr) : inner(ptr) {}
-                ~IoIter() { delete inner; }
-
-                IoIter(const IoIter& oth) :
-                    inner(oth.inner->clone()) {}
-                IoIter& operator=(const IoIter& oth) {
-                    delete inner;
-                    inner = oth.inner->clone();
-                    return *this;
-                }
-
-                IoIter& operator++() {
-                    ++(*inner);
-                    return *this;
-                }
-                IoIter operator++(int) {
-                    IoIter out(*this);
-                    operator++();
-                    return out;
-                }
-                WireId* operator*() const { return *(*inner); }
-
-                bool operator==(const IoIter& oth) const {
-                    return inner == oth.inner || (*inner) == (*oth.inner);
-                }
-
-                bool operator!=(const IoIter& oth) const {
-                    return !(operator==(oth));
-                }
-
-            private:
-                InnerIoIter* inner;
-        };
+        typedef WireSpan::iterator IoIter;
 
         CircuitTree();
         virtual ~CircuitTree();
@@ -100,6 +55,15 @@ class CircuitTree {
          */
         sign_t sign(int level=2);
 
+        /**
+         * Signs every circuit of `circs` at `level`, level by level: all the
+         * level-0 signatures are computed first as a batch (see `batchSign`),
+         * then each level reuses the memoized signatures of the previous one.
+         * Equivalent to calling `sign(level)` on every circuit.
+         */
+        static void signAll(const std::vector<CircuitTree*>& circs,
+                int level=2);
+
         /**
          * Checks whether this circuit is formally equal to its argument, wrt.
          * permutations, names, etc. This does not take into account the gate's
@@ -107,6 +71,12 @@ class CircuitTree {
          */
         bool equals(CircuitTree* oth);
 
+        /** Builds a copy of the leaf gate `leaf`, connected to `wires`, given
+         * in the order of `leaf->io_wires()`. Returns `nullptr` if `leaf` is
+         * a group. */
+        static CircuitTree* copyLeaf(const CircuitTree* leaf,
+                WireId* const* wires);
+
         /**
          * O(1) comparaison using IDs
          */
@@ -121,20 +91,41 @@ class CircuitTree {
         /** Get this circuit's id */
         size_t id() const { return circuitId; }
 
+        /** Get the position of this circuit in its ancestor's children,
+         * dense in `[0, ancestor()->getChildren().size())`. After the
+         * children were modified through the mutable
+         * `CircuitGroup::getChildren`, it is only up to date once the
+         * ancestor's `leafStore` was rebuilt. */
+        size_t childIndex() const { return childPos; }
+
+        /** Get the I/O wires of the gate as a contiguous span, inputs first.
+         * Unconnected group pins are skipped. */
+        virtual WireSpan io_wires() const = 0;
+
+        /** Get the input wires of the gate, that is, the beginning of
+         * `io_wires()` */
+        virtual WireSpan inp_wires() const = 0;
+
+        /** Get the output wires of the gate, that is, the end of
+         * `io_wires()` */
+        WireSpan out_wires() const {
+            return WireSpan(inp_wires().end(), io_wires().end());
+        }
+
         /** Get an iterator to the first input wire */
-        virtual IoIter inp_begin() const = 0;
+        IoIter inp_begin() const { return inp_wires().begin(); }
 
         /** Get an iterator to the end of input wires */
-        IoIter inp_end() const { return out_begin(); }
+        IoIter inp_end() const { return inp_wires().end(); }
 
         /** Get an iterator to the first output wire */
-        virtual IoIter out_begin() const = 0;
+        IoIter out_begin() const { return inp_end(); }
 
         /** Get an iterator to the end of output wires */
-        virtual IoIter out_end() const = 0;
+        IoIter out_end() const { return io_wires().end(); }
 
         /** Get an iterator to the first I/O wire */
-        IoIter io_begin() const { return inp_begin(); }
+        IoIter io_begin() const { return io_wires().begin(); }
 
         /** Get an iterator to the end of output wires */
         IoIter io_end() const { return out_end(); }
@@ -155,7 +146,9 @@ class CircuitTree {
         /** Unplug the circuit from its ancestor, that is, disconnects every
          * wire. You **should** delete this circuit right after it has been
          * unplugged, as its internal state is not cleaned up and will most
-         * probably break up in mean and inventive ways if you try to reuse it
+         * probably break up in mean and inventive ways if you try to reuse it.
+         * This runs in time linear in the number of wires of this circuit,
+         * and keeps the order of its ancestor's other children.
          */
         virtual void unplug();
 
@@ -179,9 +172,14 @@ class CircuitTree {
          * lower-level signature of a block. */
         virtual sign_t computeSignature(int level);
 
-        /** Computes the inner signature of a gate. This should be
-         * reimplemented for every gate type. */
-        virtual sign_t innerSignature() const = 0;
+        /** Computes the inner signature of a gate, that is, its mixed
+         * `innerSignatureKey`. */
+        sign_t innerSignature() const;
+
+        /** Computes the hash of the gate's type and contents, before mixing
+         * it into its inner signature. This should be reimplemented for every
+         * gate type. */
+        virtual sign_t innerSignatureKey() const = 0;
 
         /** Computes the actual equality of two gates, assumed of the same type
          */
@@ -198,6 +196,14 @@ class CircuitTree {
 
         memo_ts_t lastAlterationTime;
 
+        /** Last alteration of any of this circuit's children, which
+         * invalidates all of their signatures. Only relevant for groups. */
+        memo_ts_t lastChildAlterationTime;
+
+        /** Global history clock: timestamps are taken from it, and can thus
+         * be compared between circuits. */
+        static memo_ts_t historyClock;
+
         struct MemoSign {
             MemoSign(memo_ts_t t, sign_t sig) : timestamp(t), sig(sig) {}
             memo_ts_t timestamp;
@@ -206,6 +212,12 @@ class CircuitTree {
 
         std::vector<MemoSign> memoSig;
 
+        /// Checks whether the signature of level `level` is memoized
+        bool isSignMemoized(int level) const;
+
+        /// Memoizes `signature` as the signature of level `level`
+        void memoizeSign(int level, sign_t signature);
+
         /** Group this circuit belongs to. This is automatically set. */
         CircuitGroup* ancestor_;
 
@@ -213,6 +225,20 @@ class CircuitTree {
         static size_t nextCircuitId;
         size_t circuitId;
 
+        /// Position of this circuit in its ancestor's children
+        size_t childPos;
+
+        /** Connection of this circuit to a wire, at position `pos` in the
+         * wire's connected circuits. Lets `WireManager` disconnect a circuit
+         * in constant time. */
+        struct WireSlot {
+            WireSlot(WireId* wire, size_t pos) : wire(wire), pos(pos) {}
+            WireId* wire;
+            size_t pos;
+        };
+        std::vector<WireSlot> wireSlots;
+
     friend class CircuitGroup;
+    friend class WireManager;
 };
 
@@ -1,31 +1,22 @@
 #include "circuitTristate.h"
 #include "signatureConstants.h"
+#include "leafStore.h"
 #include "dotPrint.h"
 
 #include <string>
 #include <cassert>
 using namespace std;
 
-void CircuitTristate::InnerIoIter::operator++() {
-    if(ptr == circ->wireInput)
-        ptr = circ->wireEnable;
-    else if(ptr == circ->wireEnable)
-        ptr = circ->wireOutput;
-    else if(ptr == circ->wireOutput)
-        ptr = NULL;
-}
-
 CircuitTristate::CircuitTristate(WireId* from, WireId* to, WireId* enable) :
-    wireInput(from), wireOutput(to), wireEnable(enable)
+    wires{from, enable, to}
 {
     from->connect(this);
     to->connect(this);
     enable->connect(this);
 }
 
-sign_t CircuitTristate::innerSignature() const {
-    return signatureConstants::opcst_leaftype(
-            (circType() << 16) + (1 << 8) + 1);
+sign_t CircuitTristate::innerSignatureKey() const {
+    return LeafStore::wireGateKey(circType());
 }
 
 bool CircuitTristate::innerEqual(CircuitTree*) {
@@ -42,15 +33,15 @@ size_t CircuitTristate::outputCount() const {
 
 WireId* CircuitTristate::nth_input(size_t circId) const {
     if(circId == 0)
-        return wireInput;
+        return wires[0];
     else if(circId == 1)
-        return wireEnable;
+        return wires[1];
     return nullptr;
 }
 
 WireId* CircuitTristate::nth_output(size_t circId) const {
     if(circId == 0)
-        return wireOutput;
+        return wires[2];
     return nullptr;
 }
 
@@ -61,13 +52,13 @@ void CircuitTristate::toDot(std::basic_ostream<char>& out, int indent) {
         << thisCirc << " "
         << "[shape=triangle, rotate=90]" << '\n';
 
-    dotPrint::inWire(out, thisCirc, wireInput->uniqueName(),
+    dotPrint::inWire(out, thisCirc, wires[0]->uniqueName(),
             "headport=w");
     dotPrint::indent(out, indent);
-    dotPrint::inWire(out, thisCirc, wireEnable->uniqueName(),
+    dotPrint::inWire(out, thisCirc, wires[1]->uniqueName(),
             "headport=n");
     dotPrint::indent(out, indent);
-    dotPrint::outWire(out, thisCirc, wireOutput->uniqueName(),
+    dotPrint::outWire(out, thisCirc, wires[2]->uniqueName(),
             "headport=e");
 }
 
@@ -3,60 +3,22 @@
 #include "circuitTree.h"
 
 class CircuitTristate : public CircuitTree {
-    protected:
-        // ========= I/O ITERATOR =============================================
-        class InnerIoIter : public CircuitTree::InnerIoIter {
-                WireId* ptr;
-                const CircuitTristate* circ;
-            public:
-                InnerIoIter(const CircuitTristate* circ, WireId* wire)
-                    : ptr(wire), circ(circ) {}
-                InnerIoIter(const InnerIoIter& it)
-                    : ptr(it.ptr), circ(it.circ) {}
-                virtual void operator++();
-                virtual WireId* operator*() { return ptr; }
-                virtual InnerIoIter* clone() const {
-                    return new InnerIoIter(*this);
-                }
-            private:
-                virtual bool equal(const CircuitTree::InnerIoIter& oth_) const
-                {
-                    const InnerIoIter& oth =
-                        static_cast<const InnerIoIter&>(oth_);
-                    return ptr == oth.ptr && circ == oth.circ;
-                }
-        };
-
     public:
-        IoIter inp_begin() const {
-            return IoIter(
-                    new InnerIoIter(this, wireInput)
-                    );
-        }
-        IoIter out_begin() const {
-            return IoIter(
-                    new InnerIoIter(this, wireOutput)
-                    );
-        }
-        IoIter out_end() const {
-            return IoIter(
-                    new InnerIoIter(this, NULL)
-                    );
-        }
-        // ========= END I/O ITERATOR =========================================
-
         CircuitTristate(WireId* from, WireId* to, WireId* enable);
 
         CircType circType() const { return CIRC_TRI; }
 
+        WireSpan io_wires() const { return WireSpan(wires, wires + 3); }
+        WireSpan inp_wires() const { return WireSpan(wires, wires + 2); }
+
         /** Gets the input wire. */
-        const WireId* input() const { return wireInput; }
+        const WireId* input() const { return wires[0]; }
 
         /** Gets the output wire. */
-        const WireId* output() const { return wireOutput; }
+        const WireId* output() const { return wires[2]; }
 
         /** Gets the enable wire. */
-        const WireId* enable() const { return wireEnable; }
+        const WireId* enable() const { return wires[1]; }
 
         // Documentation in CircuitTree*
         size_t inputCount() const;
@@ -67,10 +29,10 @@ class CircuitTristate : public CircuitTree {
         void toDot(std::basic_ostream<char>& out, int indent=0);
 
     protected:
-        virtual sign_t innerSignature() const;
+        virtual sign_t innerSignatureKey() const;
         virtual bool innerEqual(CircuitTree* othTree);
 
     private:
-        WireId *wireInput, *wireOutput, *wireEnable;
+        WireId* wires[3]; ///< Input, enable, output
 };
 
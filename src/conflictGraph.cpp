@@ -0,0 +1,217 @@
+#include "conflictGraph.h"
+
+#include <algorithm>
+#include <set>
+
+#include "dyn_bitset.h"
+
+using namespace std;
+
+const size_t ConflictGraph::EXACT_MAX;
+
+namespace {
+
+typedef ConflictGraph::Clock Clock;
+
+/// Number of search steps between two checks of the deadline
+const size_t CHECK_PERIOD = 1024;
+
+/** Branch and bound search of a maximum independent set, in a component
+ * whose vertices are numbered in `[0, adjacency.size())` */
+class ExactSearch {
+    public:
+        /** `best` is the best set known beforehand, eg. a greedy one, which
+         * is kept if no larger one is found */
+        ExactSearch(const vector<DynBitset>& adjacency,
+                Clock::time_point deadline, const vector<size_t>& best);
+
+        /// Runs the search, until its end or the deadline
+        void run();
+
+        /// Best set found
+        const vector<size_t>& best() const { return best_; }
+
+    private:
+        /// Extends `chosen` with the vertices of `candidates`
+        void search(DynBitset candidates);
+
+        const vector<DynBitset>& adjacency;
+        /// Vertices that are neither a given vertex nor its neighbours
+        vector<DynBitset> compatible;
+        Clock::time_point deadline;
+        size_t steps;
+        bool interrupted;
+        vector<size_t> chosen, best_;
+};
+
+ExactSearch::ExactSearch(const vector<DynBitset>& adjacency,
+        Clock::time_point deadline, const vector<size_t>& best)
+    : adjacency(adjacency), deadline(deadline), steps(0),
+    interrupted(false), best_(best)
+{
+    compatible.reserve(adjacency.size());
+    for(size_t vert = 0; vert < adjacency.size(); ++vert) {
+        compatible.push_back(~adjacency[vert]);
+        compatible.back()[vert].reset();
+    }
+}
+
+void ExactSearch::run() {
+    DynBitset candidates(adjacency.size());
+    candidates.flip();
+    search(candidates);
+}
+
+void ExactSearch::search(DynBitset candidates) {
+    if(interrupted)
+        return;
+    if(++steps % CHECK_PERIOD == 0 && Clock::now() >= deadline) {
+        interrupted = true;
+        return;
+    }
+    size_t chosenBefore = chosen.size();
+
+    // A vertex with at most one neighbour among the candidates is part of
+    // some maximum set: take it right away. Otherwise, branch on a vertex of
+    // maximal degree.
+    size_t pick = 0;
+    bool reduced = true;
+    while(reduced) {
+        reduced = false;
+        size_t maxDegree = 0;
+        for(auto vert = candidates.setBits_begin();
+                vert != candidates.setBits_end(); ++vert)
+        {
+            size_t degree = (adjacency[*vert] & candidates).count();
+            if(degree <= 1) {
+                chosen.push_back(*vert);
+                candidates &= compatible[*vert];
+                reduced = true;
+                break;
+            }
+            if(degree > maxDegree) {
+                maxDegree = degree;
+                pick = *vert;
+            }
+        }
+    }
+
+    if(!candidates.any()) {
+        if(chosen.size() > best_.size())
+            best_ = chosen;
+    }
+    else if(chosen.size() + candidates.count() > best_.size()) {
+        chosen.push_back(pick);
+        search(candidates & compatible[pick]);
+        chosen.pop_back();
+
+        candidates[pick].reset();
+        search(candidates);
+    }
+    chosen.resize(chosenBefore);
+}
+
+/** Independent set of `component`, built by repeatedly selecting a vertex of
+ * minimal degree and dropping its neighbours. `removed` must be clear on the
+ * component's vertices; `degree` is scratch space, by vertex. */
+vector<size_t> greedySet(const vector<size_t>& component,
+        const vector<vector<size_t> >& adjacency,
+        vector<bool>& removed, vector<size_t>& degree)
+{
+    if(component.size() == 1)
+        return component;
+
+    set<pair<size_t, size_t> > queue; // By degree, then vertex
+    for(auto vert: component) {
+        degree[vert] = adjacency[vert].size();
+        queue.insert(make_pair(degree[vert], vert));
+    }
+
+    vector<size_t> out;
+    while(!queue.empty()) {
+        size_t vert = queue.begin()->second;
+        out.push_back(vert);
+
+        queue.erase(make_pair(degree[vert], vert));
+        removed[vert] = true;
+        for(auto neigh: adjacency[vert]) {
+            if(removed[neigh])
+                continue;
+            queue.erase(make_pair(degree[neigh], neigh));
+            removed[neigh] = true;
+            for(auto second: adjacency[neigh]) {
+                if(removed[second])
+                    continue;
+                queue.erase(make_pair(degree[second], second));
+                --degree[second];
+                queue.insert(make_pair(degree[second], second));
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+void ConflictGraph::addConflict(size_t fst, size_t snd) {
+    if(fst == snd)
+        return;
+    adjacency[fst].push_back(snd);
+    adjacency[snd].push_back(fst);
+}
+
+std::vector<size_t> ConflictGraph::maxIndependentSet(
+        Clock::time_point deadline) const
+{
+    vector<vector<size_t> > adj = adjacency;
+    for(auto& neighs: adj) {
+        sort(neighs.begin(), neighs.end());
+        neighs.erase(unique(neighs.begin(), neighs.end()), neighs.end());
+    }
+
+    vector<size_t> out;
+    vector<bool> visited(adj.size(), false), removed(adj.size(), false);
+    vector<size_t> localId(adj.size()), degree(adj.size());
+    vector<size_t> component;
+    for(size_t root = 0; root < adj.size(); ++root) {
+        if(visited[root])
+            continue;
+
+        // Collect the connected component of `root`
+        component.assign(1, root);
+        visited[root] = true;
+        for(size_t pos = 0; pos < component.size(); ++pos) {
+            for(auto neigh: adj[component[pos]]) {
+                if(!visited[neigh]) {
+                    visited[neigh] = true;
+                    component.push_back(neigh);
+                }
+            }
+        }
+
+        vector<size_t> best = greedySet(component, adj, removed, degree);
+        if(component.size() > 2 && component.size() <= EXACT_MAX
+                && Clock::now() < deadline)
+        {
+            for(size_t pos = 0; pos < component.size(); ++pos)
+                localId[component[pos]] = pos;
+            vector<DynBitset> localAdj(component.size(),
+                    DynBitset(component.size()));
+            for(size_t pos = 0; pos < component.size(); ++pos)
+                for(auto neigh: adj[component[pos]])
+                    localAdj[pos][localId[neigh]].set();
+
+            for(auto& vert: best)
+                vert = localId[vert];
+            ExactSearch exact(localAdj, deadline, best);
+            exact.run();
+            best = exact.best();
+            for(auto& vert: best)
+                vert = component[vert];
+        }
+        out.insert(out.end(), best.begin(), best.end());
+    }
+
+    sort(out.begin(), out.end());
+    return out;
+}
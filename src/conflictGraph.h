@@ -0,0 +1,48 @@
+/** Conflict graph between candidate objects, eg. overlapping matches.
+ *
+ * Two vertices are in conflict whenever they cannot be selected together;
+ * `maxIndependentSet` then selects as many vertices as possible without any
+ * conflict between them. This is NP-hard in general, but conflict graphs
+ * between matches are mostly made of many small connected components: each
+ * one is solved exactly when small enough and time allows, and greedily
+ * otherwise.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+class ConflictGraph {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /// Largest connected component whose maximum set is searched exactly
+        static const size_t EXACT_MAX = 128;
+
+        /// Graph of `vertices` vertices, free of conflicts
+        ConflictGraph(size_t vertices) : adjacency(vertices) {}
+
+        /// Number of vertices
+        size_t size() const { return adjacency.size(); }
+
+        /// Marks `fst` and `snd` as conflicting, if they are distinct
+        void addConflict(size_t fst, size_t snd);
+
+        /** Selects a maximal set of pairwise non-conflicting vertices, in
+         * increasing order.
+         *
+         * Each connected component is first solved greedily, repeatedly
+         * selecting a vertex of minimal degree. Then, if it has at most
+         * `EXACT_MAX` vertices, its maximum set is searched by branch and
+         * bound until `deadline`, after which the components left keep their
+         * best set found so far. The returned set is thus maximum if the
+         * deadline was not reached, and all the components were small
+         * enough.
+         */
+        std::vector<size_t> maxIndependentSet(Clock::time_point deadline)
+            const;
+
+    private:
+        std::vector<std::vector<size_t> > adjacency; ///< May hold duplicates
+};
@@ -2,6 +2,225 @@
 
 #include <cstring>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DYN_BITSET_SIMD
+#include <immintrin.h>
+#endif
+
+/** Word-wise kernels of `DynBitset`, in scalar, AVX2 and AVX-512 flavours.
+ * The vector flavours handle the last words, that do not fill a vector, with
+ * the scalar loops. */
+namespace {
+    typedef long unsigned Word;
+
+    void andScalar(Word* dst, const Word* src, size_t count) {
+        for(size_t word = 0; word < count; ++word)
+            dst[word] &= src[word];
+    }
+
+    void orScalar(Word* dst, const Word* src, size_t count) {
+        for(size_t word = 0; word < count; ++word)
+            dst[word] |= src[word];
+    }
+
+    void xorScalar(Word* dst, const Word* src, size_t count) {
+        for(size_t word = 0; word < count; ++word)
+            dst[word] ^= src[word];
+    }
+
+    bool intersectsScalar(const Word* fst, const Word* snd, size_t count) {
+        for(size_t word = 0; word < count; ++word)
+            if(fst[word] & snd[word])
+                return true;
+        return false;
+    }
+
+    /// Position of the first non-zero word, or `count` if there is none
+    size_t firstNonZeroScalar(const Word* words, size_t count) {
+        size_t word = 0;
+        while(word < count && words[word] == 0)
+            ++word;
+        return word;
+    }
+
+    size_t countScalar(const Word* words, size_t count) {
+        size_t out = 0;
+        for(size_t word = 0; word < count; ++word)
+            out += __builtin_popcountl(words[word]);
+        return out;
+    }
+
+#ifdef DYN_BITSET_SIMD
+    __attribute__((target("popcnt")))
+    size_t countPopcnt(const Word* words, size_t count) {
+        size_t out = 0;
+        for(size_t word = 0; word < count; ++word)
+            out += __builtin_popcountl(words[word]);
+        return out;
+    }
+
+    // == AVX2: 4 words at a time
+
+    /// Defines the AVX2 kernel `name`, applying `op` to `dst` and `src`
+#define AVX2_BINARY_KERNEL(name, op, scalar) \
+    __attribute__((target("avx2"))) \
+    void name(Word* dst, const Word* src, size_t count) { \
+        size_t word = 0; \
+        for(; word + 4 <= count; word += 4) { \
+            __m256i val = _mm256_loadu_si256((const __m256i*)(dst + word)); \
+            __m256i oth = _mm256_loadu_si256((const __m256i*)(src + word)); \
+            _mm256_storeu_si256((__m256i*)(dst + word), op(val, oth)); \
+        } \
+        scalar(dst + word, src + word, count - word); \
+    }
+
+    AVX2_BINARY_KERNEL(andAvx2, _mm256_and_si256, andScalar)
+    AVX2_BINARY_KERNEL(orAvx2, _mm256_or_si256, orScalar)
+    AVX2_BINARY_KERNEL(xorAvx2, _mm256_xor_si256, xorScalar)
+#undef AVX2_BINARY_KERNEL
+
+    __attribute__((target("avx2")))
+    bool intersectsAvx2(const Word* fst, const Word* snd, size_t count) {
+        size_t word = 0;
+        for(; word + 4 <= count; word += 4) {
+            __m256i val = _mm256_loadu_si256((const __m256i*)(fst + word));
+            __m256i oth = _mm256_loadu_si256((const __m256i*)(snd + word));
+            if(!_mm256_testz_si256(val, oth))
+                return true;
+        }
+        return intersectsScalar(fst + word, snd + word, count - word);
+    }
+
+    __attribute__((target("avx2")))
+    size_t firstNonZeroAvx2(const Word* words, size_t count) {
+        size_t word = 0;
+        for(; word + 4 <= count; word += 4) {
+            __m256i val = _mm256_loadu_si256((const __m256i*)(words + word));
+            if(!_mm256_testz_si256(val, val))
+                break;
+        }
+        return word + firstNonZeroScalar(words + word, count - word);
+    }
+
+    // == AVX-512: 8 words at a time
+
+#define AVX512_BINARY_KERNEL(name, op, scalar) \
+    __attribute__((target("avx512f"))) \
+    void name(Word* dst, const Word* src, size_t count) { \
+        size_t word = 0; \
+        for(; word + 8 <= count; word += 8) { \
+            __m512i val = _mm512_loadu_si512(dst + word); \
+            __m512i oth = _mm512_loadu_si512(src + word); \
+            _mm512_storeu_si512(dst + word, op(val, oth)); \
+        } \
+        scalar(dst + word, src + word, count - word); \
+    }
+
+    AVX512_BINARY_KERNEL(andAvx512, _mm512_and_si512, andAvx2)
+    AVX512_BINARY_KERNEL(orAvx512, _mm512_or_si512, orAvx2)
+    AVX512_BINARY_KERNEL(xorAvx512, _mm512_xor_si512, xorAvx2)
+#undef AVX512_BINARY_KERNEL
+
+    __attribute__((target("avx512f")))
+    bool intersectsAvx512(const Word* fst, const Word* snd, size_t count) {
+        size_t word = 0;
+        for(; word + 8 <= count; word += 8) {
+            __m512i val = _mm512_loadu_si512(fst + word);
+            __m512i oth = _mm512_loadu_si512(snd + word);
+            if(_mm512_test_epi64_mask(val, oth) != 0)
+                return true;
+        }
+        return intersectsAvx2(fst + word, snd + word, count - word);
+    }
+
+    __attribute__((target("avx512f")))
+    size_t firstNonZeroAvx512(const Word* words, size_t count) {
+        size_t word = 0;
+        for(; word + 8 <= count; word += 8) {
+            __m512i val = _mm512_loadu_si512(words + word);
+            if(_mm512_test_epi64_mask(val, val) != 0)
+                break;
+        }
+        return word + firstNonZeroAvx2(words + word, count - word);
+    }
+#endif // DYN_BITSET_SIMD
+
+    struct Kernels {
+        void (*andWords)(Word*, const Word*, size_t);
+        void (*orWords)(Word*, const Word*, size_t);
+        void (*xorWords)(Word*, const Word*, size_t);
+        bool (*intersects)(const Word*, const Word*, size_t);
+        size_t (*firstNonZero)(const Word*, size_t);
+        size_t (*count)(const Word*, size_t);
+    };
+
+    const Kernels scalarKernels = {
+        andScalar, orScalar, xorScalar,
+        intersectsScalar, firstNonZeroScalar, countScalar
+    };
+
+    /// Best kernels supported by this CPU, chosen on first use
+    const Kernels& simdKernels() {
+#ifdef DYN_BITSET_SIMD
+        static const Kernels avx512Kernels = {
+            andAvx512, orAvx512, xorAvx512,
+            intersectsAvx512, firstNonZeroAvx512, countPopcnt
+        };
+        static const Kernels avx2Kernels = {
+            andAvx2, orAvx2, xorAvx2,
+            intersectsAvx2, firstNonZeroAvx2, countPopcnt
+        };
+        static const Kernels& best =
+            __builtin_cpu_supports("avx512f") ? avx512Kernels
+            : __builtin_cpu_supports("avx2") ? avx2Kernels
+            : scalarKernels;
+        return best;
+#else
+        return scalarKernels;
+#endif
+    }
+
+    bool simdEnabled = true;
+
+    /** Kernels to use on `count` words: below a vector's worth of words, the
+     * indirect call is not worth it */
+    inline const Kernels& kernels(size_t count) {
+        if(count < 4 || !simdEnabled)
+            return scalarKernels;
+        return simdKernels();
+    }
+}
+
+bool DynBitset::simdAvailable() {
+    return &simdKernels() != &scalarKernels;
+}
+
+void DynBitset::setSimdEnabled(bool enabled) {
+    simdEnabled = enabled;
+}
+
+DynBitset::SetBitIterator::SetBitIterator(const DynBitset::Word* words,
+        size_t nbWords, size_t wordPos) :
+    words(words), nbWords(nbWords), wordPos(wordPos),
+    curWord(wordPos < nbWords ? words[wordPos] : 0)
+{
+    if(curWord == 0)
+        skipEmpty();
+}
+
+void DynBitset::SetBitIterator::skipEmpty() {
+    if(wordPos >= nbWords)
+        return;
+    ++wordPos;
+    // The next set bit is often close: check the next word first
+    if(wordPos < nbWords && words[wordPos] == 0) {
+        ++wordPos;
+        wordPos += kernels(nbWords - wordPos).firstNonZero(
+                words + wordPos, nbWords - wordPos);
+    }
+    curWord = wordPos < nbWords ? words[wordPos] : 0;
+}
+
 DynBitset::Reference& DynBitset::Reference::operator=(bool e) {
     if(e)
         set();
@@ -21,38 +240,49 @@ DynBitset::Reference& DynBitset::Reference::operator=(
 }
 
 DynBitset::DynBitset(size_t size)
-    : size_(size)
+    : size_(size), borrowed(false)
 {
-    data = new Word[nbWords()];
+    data = nbWords() <= INLINE_WORDS ? inlineWords : new Word[nbWords()];
     reset();
 }
 
 DynBitset::DynBitset(const DynBitset& oth)
-    : size_(oth.size_)
+    : size_(oth.size_), borrowed(false)
 {
-    data = new Word[nbWords()];
+    data = nbWords() <= INLINE_WORDS ? inlineWords : new Word[nbWords()];
     memcpy(data, oth.data, nbWords() * sizeof(Word));
     // We assume `oth`'s last bits are 0s, as it should be
 }
 
-DynBitset::DynBitset(size_t size, Word* words)
-    : size_(size), data(words)
-{}
-
 DynBitset::DynBitset(DynBitset&& oth)
-    : size_(oth.size_), data(oth.data)
+    : size_(oth.size_), borrowed(false)
 {
-    // This could seriously mess things up if called improperly
-    oth.data = nullptr;
+    if(!oth.ownsHeap()) {
+        data = nbWords() <= INLINE_WORDS ? inlineWords : new Word[nbWords()];
+        memcpy(data, oth.data, nbWords() * sizeof(Word));
+        return;
+    }
+    data = oth.data;
+    oth.data = oth.inlineWords;
+    oth.size_ = 0;
 }
 
-DynBitset::~DynBitset() {
-    delete[] data;
+DynBitset& DynBitset::operator=(const DynBitset& oth) {
+    checkSize(oth);
+    memcpy(data, oth.data, nbWords() * sizeof(Word));
+    return *this;
 }
 
-void DynBitset::operator=(const DynBitset& oth) {
+DynBitset& DynBitset::operator=(DynBitset&& oth) {
+    if(!ownsHeap() || !oth.ownsHeap())
+        return operator=(static_cast<const DynBitset&>(oth));
+
     checkSize(oth);
-    memcpy(data, oth.data, nbWords() * sizeof(Word));
+    delete[] data;
+    data = oth.data;
+    oth.data = oth.inlineWords;
+    oth.size_ = 0;
+    return *this;
 }
 
 DynBitset::Reference DynBitset::operator[](size_t pos) {
@@ -61,22 +291,19 @@ DynBitset::Reference DynBitset::operator[](size_t pos) {
 
 DynBitset& DynBitset::operator&=(const DynBitset& oth) {
     checkSize(oth);
-    for(size_t word = 0; word < nbWords(); ++word)
-        data[word] &= oth.data[word];
+    kernels(nbWords()).andWords(data, oth.data, nbWords());
     return *this;
 }
 
 DynBitset& DynBitset::operator|=(const DynBitset& oth) {
     checkSize(oth);
-    for(size_t word = 0; word < nbWords(); ++word)
-        data[word] |= oth.data[word];
+    kernels(nbWords()).orWords(data, oth.data, nbWords());
     return *this;
 }
 
 DynBitset& DynBitset::operator^=(const DynBitset& oth) {
     checkSize(oth);
-    for(size_t word = 0; word < nbWords(); ++word)
-        data[word] ^= oth.data[word];
+    kernels(nbWords()).xorWords(data, oth.data, nbWords());
     return *this;
 }
 
@@ -88,9 +315,10 @@ DynBitset& DynBitset::flip() {
     Word lastMask = 0;
     lastMask = ~lastMask;
     size_t lastWordBits = size_ % word_size;
-    if(lastWordBits > 0)
+    if(lastWordBits > 0) {
         lastMask >>= word_size - lastWordBits;
-    data[nbWords() - 1] &= lastMask;
+        data[nbWords() - 1] &= lastMask;
+    }
 
     return *this;
 }
@@ -128,49 +356,59 @@ void DynBitset::reset() {
 }
 
 bool DynBitset::any() const {
-    for(size_t word = 0; word < nbWords(); ++word)
-        if(data[word] != 0)
-            return true;
-    return false;
+    return kernels(nbWords()).firstNonZero(data, nbWords()) < nbWords();
 }
 
 bool DynBitset::anyOver(size_t pos) const {
-    size_t firstWord = pos / word_size;
-
-    Word firstMask = 0;
-    firstMask = ~firstMask;
-    firstMask <<= (pos % word_size);
-    if(data[firstWord] & firstMask)
-        return true;
-
-    for(size_t word = firstWord + 1; word < nbWords(); ++word)
-        if(data[word] != 0)
-            return true;
-    return false;
-}
-
-int DynBitset::whichBit(DynBitset::Word word, int offset) const {
-    for(int bit = 0; word != 0; ++bit) {
-        if(word & 0x1lu) {
-            if(word != 1)
-                return -1;
-            return offset + bit;
-        }
-        word >>= 1;
-    }
-    return -1;
+    return findFrom(pos) < size_;
+}
+
+bool DynBitset::intersects(const DynBitset& oth) const {
+    checkSize(oth);
+    return kernels(nbWords()).intersects(data, oth.data, nbWords());
+}
+
+size_t DynBitset::count() const {
+    return kernels(nbWords()).count(data, nbWords());
+}
+
+size_t DynBitset::findFirst() const {
+    return findFrom(0);
+}
+
+size_t DynBitset::findNext(size_t pos) const {
+    return findFrom(pos + 1);
+}
+
+size_t DynBitset::findFrom(size_t pos) const {
+    if(pos >= size_)
+        return size_;
+
+    size_t word = pos / word_size;
+    Word rest = data[word] & (~0lu << (pos % word_size));
+    if(rest != 0)
+        return word * word_size + __builtin_ctzl(rest);
+
+    ++word;
+    word += kernels(nbWords() - word).firstNonZero(
+            data + word, nbWords() - word);
+    if(word >= nbWords())
+        return size_;
+    return word * word_size + __builtin_ctzl(data[word]);
 }
 
 int DynBitset::singleBit() const {
-    int singlePos = -2;
-    for(size_t word = 0; word < nbWords(); ++word) {
-        if(data[word] != 0) {
-            if(singlePos >= 0)
-                return -1;
-            singlePos = whichBit(data[word], word * word_size);
-        }
-    }
-    return singlePos;
+    size_t first = findFirst();
+    if(first >= size_)
+        return -1;
+    size_t word = first / word_size;
+    if((data[word] & (data[word] - 1)) != 0) // Another bit in the same word
+        return -1;
+    ++word;
+    if(kernels(nbWords() - word).firstNonZero(data + word, nbWords() - word)
+            < nbWords() - word)
+        return -1;
+    return first;
 }
 
 std::string DynBitset::dump() const {
@@ -185,3 +423,45 @@ std::string DynBitset::dump() const {
     }
     return out;
 }
+
+BitMatrix::BitMatrix(size_t rows, size_t cols)
+    : rows_(rows), cols_(cols),
+    rowWords((cols + DynBitset::word_size - 1) / DynBitset::word_size)
+{
+    words = new DynBitset::Word[rows_ * rowWords];
+    memset(words, 0, rows_ * rowWords * sizeof(DynBitset::Word));
+}
+
+BitMatrix::BitMatrix(const BitMatrix& oth)
+    : rows_(oth.rows_), cols_(oth.cols_), rowWords(oth.rowWords)
+{
+    words = new DynBitset::Word[rows_ * rowWords];
+    memcpy(words, oth.words, rows_ * rowWords * sizeof(DynBitset::Word));
+}
+
+BitMatrix::BitMatrix(BitMatrix&& oth)
+    : rows_(oth.rows_), cols_(oth.cols_), rowWords(oth.rowWords),
+    words(oth.words)
+{
+    oth.rows_ = 0;
+    oth.words = nullptr;
+}
+
+BitMatrix::~BitMatrix() {
+    delete[] words;
+}
+
+BitMatrix& BitMatrix::operator=(const BitMatrix& oth) {
+    if(rows_ != oth.rows_ || cols_ != oth.cols_)
+        throw DynBitset::SizeMismatch();
+    memcpy(words, oth.words, rows_ * rowWords * sizeof(DynBitset::Word));
+    return *this;
+}
+
+void BitMatrix::andRows(const DynBitset& mask) {
+    if(mask.size() != cols_)
+        throw DynBitset::SizeMismatch();
+    const Kernels& rowKernels = kernels(rowWords);
+    for(size_t row = 0; row < rows_; ++row)
+        rowKernels.andWords(words + row * rowWords, mask.data, rowWords);
+}
@@ -14,9 +14,17 @@
  * The size of the bitset must be known at allocation time, and cannot be
  * changed afterwards (apart from copying the bitset to a freshly allocated
  * one).
+ *
+ * The word-wise operations (bitwise operators, `any`, `intersects`, `count`,
+ * …) use AVX-512 or AVX2 kernels when the CPU supports them, chosen at
+ * runtime, and a scalar loop otherwise.
+ *
+ * Small bitsets (up to `INLINE_WORDS` words) are stored inline, without any
+ * heap allocation. A `DynBitset` can also be a row of a `BitMatrix` (see
+ * `BitMatrix::Row`), whose words it then borrows.
  */
 class DynBitset {
-    private:
+    protected:
         typedef long unsigned Word;
 
     public:
@@ -67,19 +75,83 @@ class DynBitset {
         };
         friend class Reference;
 
+        /** Iterator over the positions of the set bits, in increasing order.
+         * It reads the bitset a word at a time: altering the bitset during
+         * the iteration only affects the words not reached yet. */
+        class SetBitIterator {
+            friend class DynBitset;
+            public:
+                /// Position of the current set bit
+                inline size_t operator*() const {
+                    return wordPos * word_size + __builtin_ctzl(curWord);
+                }
+
+                /// Moves to the next set bit
+                inline SetBitIterator& operator++() {
+                    curWord &= curWord - 1; // Clears the lowest set bit
+                    if(curWord == 0)
+                        skipEmpty();
+                    return *this;
+                }
+
+                inline bool operator==(const SetBitIterator& oth) const {
+                    return wordPos == oth.wordPos && curWord == oth.curWord;
+                }
+                inline bool operator!=(const SetBitIterator& oth) const {
+                    return !operator==(oth);
+                }
+
+            private:
+                SetBitIterator(const DynBitset::Word* words, size_t nbWords,
+                        size_t wordPos);
+
+                /// Moves to the next non-empty word, if any
+                void skipEmpty();
+
+                const DynBitset::Word* words;
+                size_t nbWords;
+                size_t wordPos;
+                DynBitset::Word curWord; ///< Bits of the word not yet seen
+        };
+
         // === Constructors and default operations ===
 
+        /// Number of words stored inline, without any allocation
+        static const size_t INLINE_WORDS = 4;
+
         /// `size` is expressed in bits. Initializes to zeroes.
         DynBitset(size_t size);
+
+        /// Copies `oth`'s bits
         DynBitset(const DynBitset& oth);
-        ~DynBitset();
-        void operator=(const DynBitset& oth);
-        DynBitset& operator=(DynBitset&& oth) = delete;
-    private:
-        /// Constructor with pre-set value
-        DynBitset(size_t size, Word* words);
+
+        /** Takes over `oth`'s heap-allocated words, leaving it empty (of
+         * size 0). If `oth`'s words are stored inline or borrowed, they are
+         * copied instead, and `oth` is left unchanged. */
         DynBitset(DynBitset&& oth);
 
+        ~DynBitset() {
+            if(ownsHeap())
+                delete[] data;
+        }
+
+        /** Copies `oth`'s bits into this bitset, which must be of the same
+         * size.
+         * @throw SizeMismatch */
+        DynBitset& operator=(const DynBitset& oth);
+
+        /** Same as the copy, but takes over `oth`'s words instead of copying
+         * them when both bitsets own heap-allocated words, leaving `oth`
+         * empty.
+         * @throw SizeMismatch */
+        DynBitset& operator=(DynBitset&& oth);
+
+    protected:
+        /// Borrows `words` (see `BitMatrix`)
+        DynBitset(size_t size, Word* words)
+            : size_(size), data(words), borrowed(true)
+        {}
+
     public:
         // === Other methods ===
 
@@ -126,6 +198,30 @@ class DynBitset {
         /// Checks if any bit above the `pos`th (incl.) is true
         bool anyOver(size_t pos) const;
 
+        /** Checks whether `*this & oth` has any bit set, without building
+         * it */
+        bool intersects(const DynBitset& oth) const;
+
+        /// Number of set bits
+        size_t count() const;
+
+        /// Position of the first set bit, or `size()` if there is none
+        size_t findFirst() const;
+
+        /** Position of the first set bit after the `pos`th (excl.), or
+         * `size()` if there is none */
+        size_t findNext(size_t pos) const;
+
+        /// Iterator to the first set bit
+        SetBitIterator setBits_begin() const {
+            return SetBitIterator(data, nbWords(), 0);
+        }
+
+        /// Past-the-end of `setBits_begin`
+        SetBitIterator setBits_end() const {
+            return SetBitIterator(data, nbWords(), nbWords());
+        }
+
         /// Checks if a single bit is set
         /** Checks whether a single bit is set. If so, returns this bit's
          * position; if no or multiple bits are set, returns -1. */
@@ -134,22 +230,107 @@ class DynBitset {
         /// Dumps the DynBitset to an hex representation
         std::string dump() const;
 
+        /// Checks whether the SIMD kernels are available on this CPU
+        static bool simdAvailable();
+
+        /** Enables or disables the SIMD kernels (if available), mostly for
+         * benchmarking and testing. Enabled by default. */
+        static void setSimdEnabled(bool enabled);
+
     private:
         inline void checkSize(const DynBitset& oth) const {
             if(size_ != oth.size_)
                 throw SizeMismatch();
         }
 
+        /** Position of the first set bit after the `pos`th (incl.), or
+         * `size()` if there is none */
+        size_t findFrom(size_t pos) const;
+
         inline size_t nbWords() const {
             return (size_ + word_size - 1) / word_size;
         }
 
-        /** Aux function for `singleBit`, does the same on a single word.
-         * Assumes every bit past `upTo` is false. */
-        int whichBit(Word word, int offset = 0) const;
+        /** Checks whether this bitset owns heap-allocated words, ie. it is
+         * neither stored inline nor borrowing its words */
+        inline bool ownsHeap() const {
+            return data != inlineWords && !borrowed;
+        }
 
-        const size_t size_;
+    protected:
+        size_t size_;
         Word* data;
 
+    private:
+        bool borrowed; ///< `data` belongs to a `BitMatrix`
+        Word inlineWords[INLINE_WORDS];
+
         constexpr static size_t word_size = sizeof(Word) * 8;
+
+    friend class BitMatrix;
+};
+
+/** Matrix of bits, stored row-major in a single contiguous buffer.
+ *
+ * Its rows are `DynBitset`s borrowing the buffer: they are built on the fly
+ * by `operator[]`, without any allocation. Copying a matrix copies the
+ * buffer at once.
+ */
+class BitMatrix {
+    public:
+        /** A row of a matrix, borrowing its words: it must not outlive the
+         * matrix. Copying a `Row` yields another view of the same row, while
+         * copying it into a plain `DynBitset` copies its bits. */
+        class Row : public DynBitset {
+            public:
+                Row(const Row& oth) : DynBitset(oth.size_, oth.data) {}
+
+                using DynBitset::operator=;
+
+                /// Copies the bits of `oth` into this row
+                Row& operator=(const Row& oth) {
+                    DynBitset::operator=(oth);
+                    return *this;
+                }
+
+            private:
+                Row(size_t size, Word* words) : DynBitset(size, words) {}
+
+            friend class BitMatrix;
+        };
+
+        /// All the bits are initialized to zero
+        BitMatrix(size_t rows, size_t cols);
+        BitMatrix(const BitMatrix& oth);
+        BitMatrix(BitMatrix&& oth);
+        ~BitMatrix();
+
+        /** Copies `oth`'s bits into this matrix, which must be of the same
+         * dimensions.
+         * @throw DynBitset::SizeMismatch */
+        BitMatrix& operator=(const BitMatrix& oth);
+
+        /// Number of rows
+        size_t rows() const { return rows_; }
+
+        /// Number of columns, that is, the size of each row
+        size_t cols() const { return cols_; }
+
+        /// The `row`-th row
+        Row operator[](size_t row) {
+            return Row(cols_, words + row * rowWords);
+        }
+
+        /// Constant version of `operator[]`
+        const Row operator[](size_t row) const {
+            return Row(cols_, words + row * rowWords);
+        }
+
+        /// In-place bitwise and of every row with `mask`
+        void andRows(const DynBitset& mask);
+
+    private:
+        size_t rows_, cols_;
+        size_t rowWords; ///< Words per row
+        DynBitset::Word* words;
 };
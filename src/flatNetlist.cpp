@@ -0,0 +1,110 @@
+#include "flatNetlist.h"
+#include "circuitGroup.h"
+
+using namespace std;
+
+FlatNetlist::FlatNetlist(CircuitGroup* root) :
+    root(root), nets(root->netIndex()), flatGroup_(nullptr)
+{
+    netWires.assign(nets.netCount(), nullptr);
+
+    // Collect the leaves depth-first, and the wires closest to the root
+    vector<pair<CircuitGroup*, size_t> > stack(1, make_pair(root, 0));
+    for(auto wire: root->wireManager()->wires())
+        netWires[nets.netOf(wire)] = wire;
+    gateOffsets.push_back(0);
+    while(!stack.empty()) {
+        CircuitGroup* group = stack.back().first;
+        size_t childPos = stack.back().second++;
+        if(childPos >= group->getChildrenCst().size()) {
+            stack.pop_back();
+            continue;
+        }
+
+        CircuitTree* child = group->getChildrenCst()[childPos];
+        if(child->circType() == CircuitTree::CIRC_GROUP) {
+            CircuitGroup* sub = static_cast<CircuitGroup*>(child);
+            for(auto wire: sub->wireManager()->wires()) {
+                size_t net = nets.netOf(wire);
+                if(netWires[net] == nullptr)
+                    netWires[net] = wire;
+            }
+            stack.push_back(make_pair(sub, 0));
+        }
+        else {
+            gates.push_back(child);
+            for(auto wire: child->io_wires())
+                gateNets.push_back(nets.netOf(wire));
+            gateOffsets.push_back(gateNets.size());
+        }
+    }
+
+    // Transpose into the gates of each net
+    netOffsets.assign(netWires.size() + 1, 0);
+    for(auto net: gateNets)
+        ++netOffsets[net + 1];
+    for(size_t net = 0; net < netWires.size(); ++net)
+        netOffsets[net + 1] += netOffsets[net];
+    netGates.resize(gateNets.size());
+    vector<size_t> fill(netOffsets.begin(), netOffsets.end() - 1);
+    for(size_t gate = 0; gate < gates.size(); ++gate) {
+        for(size_t pos = gateOffsets[gate]; pos < gateOffsets[gate + 1];
+                ++pos)
+        {
+            netGates[fill[gateNets[pos]]++] = gate;
+        }
+    }
+}
+
+FlatNetlist::~FlatNetlist() {
+    delete flatGroup_;
+}
+
+CircuitGroup* FlatNetlist::flatGroup() {
+    if(flatGroup_ != nullptr)
+        return flatGroup_;
+
+    flatGroup_ = new CircuitGroup(root->name());
+    WireManager* manager = flatGroup_->wireManager();
+    for(size_t net = 0; net < netWires.size(); ++net)
+        manager->fresh(); // Wire of id `net`
+
+    const CircuitGroup* cstRoot = root;
+    for(auto pin: cstRoot->getInputs())
+        flatGroup_->addInput(pin->formalName(),
+                manager->wire(netOf(pin->actual())));
+    for(auto pin: cstRoot->getOutputs())
+        flatGroup_->addOutput(pin->formalName(),
+                manager->wire(netOf(pin->actual())));
+
+    for(size_t gate = 0; gate < gates.size(); ++gate) {
+        CircuitTree* copy = flatCopy(gate, manager);
+        flatGateId[copy] = gate;
+        flatGroup_->addChild(copy);
+    }
+    return flatGroup_;
+}
+
+std::vector<MatchResult> FlatNetlist::find(CircuitGroup* needle) {
+    FlatNetlist flatNeedle(needle);
+    vector<MatchResult> results =
+        matchSubcircuit(flatNeedle.flatGroup(), flatGroup());
+
+    for(auto& result: results) {
+        for(auto& part: result.parts)
+            part = gates[flatGateId.at(part)];
+        for(auto& wire: result.inputs)
+            wire = netWires[wire->id()];
+        for(auto& wire: result.outputs)
+            wire = netWires[wire->id()];
+    }
+    return results;
+}
+
+CircuitTree* FlatNetlist::flatCopy(size_t gate, WireManager* manager) const {
+    vector<WireId*> wires;
+    for(auto net = gateNets_begin(gate); net != gateNets_end(gate); ++net)
+        wires.push_back(manager->wire(*net));
+
+    return CircuitTree::copyLeaf(gates[gate], wires.data());
+}
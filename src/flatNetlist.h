@@ -0,0 +1,101 @@
+/** Flattening of a circuit hierarchy into a flat netlist.
+ *
+ * A `FlatNetlist` sees a hierarchy as its leaf gates connected by global
+ * nets (see `NetIndex`), forgetting about the groups. Both the gates' nets
+ * and the nets' gates are stored in compressed sparse row form, and every
+ * flat gate and net maps back to the original `CircuitTree`s and `WireId`s.
+ *
+ * It can also be searched with `find`, which then matches patterns spanning
+ * across group boundaries.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "netIndex.h"
+#include "subcircMatch.h"
+
+class CircuitTree;
+class CircuitGroup;
+class WireId;
+
+class FlatNetlist {
+    public:
+        /** Flattens the hierarchy rooted at `root`, from its cached
+         * `CircuitGroup::netIndex`. The hierarchy must not be altered while
+         * this object lives. */
+        FlatNetlist(CircuitGroup* root);
+
+        /// Deletes the `flatGroup`, if any
+        ~FlatNetlist();
+
+        FlatNetlist(const FlatNetlist&) = delete;
+        FlatNetlist& operator=(const FlatNetlist&) = delete;
+
+        /// Number of leaf gates in the hierarchy
+        size_t gateCount() const { return gates.size(); }
+
+        /// Number of nets in the hierarchy
+        size_t netCount() const { return netWires.size(); }
+
+        /** Get the original gate of the flat gate `gate`. Gates are
+         * numbered in depth-first order of the hierarchy. */
+        CircuitTree* gate(size_t gate) const { return gates[gate]; }
+
+        /** Get an original wire of the net `net`, the closest to the root of
+         * the hierarchy. */
+        WireId* netWire(size_t net) const { return netWires[net]; }
+
+        /// Get the net of `wire`, or `NetIndex::NO_NET`
+        size_t netOf(const WireId* wire) const { return nets.netOf(wire); }
+
+        /// First net of the I/O wires of `gate`, in the order of `io_wires`
+        const size_t* gateNets_begin(size_t gate) const {
+            return gateNets.data() + gateOffsets[gate];
+        }
+        /// Past-the-end of `gateNets_begin`
+        const size_t* gateNets_end(size_t gate) const {
+            return gateNets.data() + gateOffsets[gate + 1];
+        }
+
+        /// First gate connected to `net`
+        const size_t* netGates_begin(size_t net) const {
+            return netGates.data() + netOffsets[net];
+        }
+        /// Past-the-end of `netGates_begin`
+        const size_t* netGates_end(size_t net) const {
+            return netGates.data() + netOffsets[net + 1];
+        }
+
+        /** Get a flat group mirroring this netlist, with a leaf per gate and
+         * a wire per net, and the I/O pins of the flattened root. It is
+         * built on first use. */
+        CircuitGroup* flatGroup();
+
+        /** Finds every match of `needle`, itself flattened, in this netlist.
+         * The results are expressed in terms of the original hierarchy, but
+         * their `parts` follow the depth-first order of the leaves of
+         * `needle` instead of its children's order. */
+        std::vector<MatchResult> find(CircuitGroup* needle);
+
+    private:
+        /// Builds the flat copy of the gate `gate` on the wires of `manager`
+        CircuitTree* flatCopy(size_t gate, WireManager* manager) const;
+
+        CircuitGroup* root;
+        const NetIndex& nets;
+
+        std::vector<CircuitTree*> gates;
+        std::vector<WireId*> netWires;
+
+        std::vector<size_t> gateOffsets;
+        std::vector<size_t> gateNets;
+        std::vector<size_t> netOffsets;
+        std::vector<size_t> netGates;
+
+        CircuitGroup* flatGroup_;
+        /// Gate of each leaf of `flatGroup_`
+        std::unordered_map<CircuitTree*, size_t> flatGateId;
+};
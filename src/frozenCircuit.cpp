@@ -0,0 +1,128 @@
+#include "frozenCircuit.h"
+#include "groupEquality.h"
+
+using namespace std;
+
+const int FrozenCircuit::MAX_LEVEL = groupEquality::MAX_PRECISION;
+
+/** Copies `pin` for the group `copy`, given the copies of the wires of the
+ * pin's outer group (`nullptr` at the root) and of the group itself */
+static IOPin copyPin(const IOPin* pin, const vector<WireId*>* formals,
+        const vector<WireId*>& actuals, CircuitGroup* copy)
+{
+    WireId* actual = actuals[pin->actual()->id()];
+    if(formals == nullptr || pin->formal() == nullptr) {
+        return IOPin(pin->formal() == nullptr ?
+                pin->formalName() : pin->formal()->name(),
+            actual, copy);
+    }
+    return IOPin((*formals)[pin->formal()->id()], actual, copy);
+}
+
+FrozenCircuit::FrozenCircuit(CircuitGroup* source) {
+    const CircuitGroup* cstSource = source;
+    root_ = new CircuitGroup(source->name());
+    origCircs[root_] = source;
+
+    vector<WireId*> wires = copyWires(source, root_);
+    for(auto pin: cstSource->getInputs())
+        root_->addInput(copyPin(pin, nullptr, wires, root_));
+    for(auto pin: cstSource->getOutputs())
+        root_->addOutput(copyPin(pin, nullptr, wires, root_));
+    copyChildren(source, root_, wires);
+
+    freeze();
+}
+
+FrozenCircuit::~FrozenCircuit() {
+    delete root_;
+}
+
+sign_t FrozenCircuit::sign(int level) const {
+    if(level < 0 || level > MAX_LEVEL)
+        throw LevelNotFrozen();
+    return root_->sign(level);
+}
+
+bool FrozenCircuit::equals(const FrozenCircuit& oth) const {
+    return root_->equals(oth.root_);
+}
+
+std::vector<MatchResult> FrozenCircuit::find(
+        const FrozenCircuit& needle) const
+{
+    return matchSubcircuit(needle.root(), root());
+}
+
+CircuitTree* FrozenCircuit::original(const CircuitTree* circ) const {
+    auto orig = origCircs.find(circ);
+    return orig == origCircs.end() ? nullptr : orig->second;
+}
+
+WireId* FrozenCircuit::original(const WireId* wire) const {
+    auto orig = origWires.find(wire);
+    return orig == origWires.end() ? nullptr : orig->second;
+}
+
+std::vector<WireId*> FrozenCircuit::copyWires(CircuitGroup* source,
+        CircuitGroup* copy)
+{
+    WireManager* srcManager = source->wireManager();
+    WireManager* manager = copy->wireManager();
+    vector<WireId*> wires(srcManager->allWires().size(), nullptr);
+    for(auto wire: srcManager->wires()) {
+        WireId* wireCopy = srcManager->isAnonymous(wire->id()) ?
+            manager->fresh() : manager->fresh(wire->name());
+        wires[wire->id()] = wireCopy;
+        origWires[wireCopy] = wire;
+    }
+    return wires;
+}
+
+void FrozenCircuit::copyChildren(CircuitGroup* source, CircuitGroup* copy,
+        const std::vector<WireId*>& wires)
+{
+    for(auto child: source->getChildrenCst()) {
+        CircuitTree* childCopy;
+        if(child->circType() == CircuitTree::CIRC_GROUP) {
+            CircuitGroup* sub = static_cast<CircuitGroup*>(child);
+            const CircuitGroup* cstSub = sub;
+            CircuitGroup* subCopy = new CircuitGroup(sub->name());
+
+            vector<WireId*> subWires = copyWires(sub, subCopy);
+            for(auto pin: cstSub->getInputs())
+                subCopy->addInput(copyPin(pin, &wires, subWires, subCopy));
+            for(auto pin: cstSub->getOutputs())
+                subCopy->addOutput(copyPin(pin, &wires, subWires, subCopy));
+            copyChildren(sub, subCopy, subWires);
+            childCopy = subCopy;
+        }
+        else {
+            vector<WireId*> ioCopy;
+            for(auto wire: child->io_wires())
+                ioCopy.push_back(wires[wire->id()]);
+            childCopy = CircuitTree::copyLeaf(child, ioCopy.data());
+        }
+        origCircs[childCopy] = child;
+        copy->addChild(childCopy);
+    }
+}
+
+void FrozenCircuit::freeze() {
+    // Every circuit of the snapshot, breadth-first
+    vector<CircuitTree*> circs(1, root_);
+    for(size_t pos = 0; pos < circs.size(); ++pos) {
+        if(circs[pos]->circType() != CircuitTree::CIRC_GROUP)
+            continue;
+        CircuitGroup* group = static_cast<CircuitGroup*>(circs[pos]);
+        group->wireManager()->freeze();
+        group->io_wires();
+        group->leafStore();
+        for(auto child: group->getChildrenCst())
+            circs.push_back(child);
+    }
+
+    // Signing every circuit at every level computes, on the way, the I/O
+    // signatures of the groups and the signatures of the expressions
+    CircuitTree::signAll(circs, MAX_LEVEL);
+}
@@ -0,0 +1,94 @@
+/** Immutable snapshot of a circuit hierarchy, for concurrent queries.
+ *
+ * Querying a `CircuitGroup` writes a lot of shared state: memoized
+ * signatures, cached I/O wires and I/O signatures, leaf stores, the wires'
+ * adjacency and union-find path compression, lazily generated wire names, …
+ * Thus, a hierarchy cannot be queried from several threads at once.
+ *
+ * A `FrozenCircuit` is a deep copy of a hierarchy on which all of this state
+ * is computed upfront, when it is built. From then on, its queries (`sign`,
+ * `equals` and `find`) only read it, and can be run from any number of
+ * threads at once without any locking. The snapshot does not refer to the
+ * original hierarchy, which can be altered or deleted once the threads
+ * querying the snapshot are done.
+ *
+ * The original hierarchy must not be used, though, while other threads query
+ * the snapshot, nor while it is built: both share unsynchronized global state
+ * with it (the `CircuitTree` history clock and the table of hash-consed
+ * expressions, shared by reference counting). When compiled with
+ * `SIG_STATS`, the statistics counters are not thread-safe either.
+ */
+
+#pragma once
+
+#include <exception>
+#include <vector>
+#include <unordered_map>
+
+#include "circuitGroup.h"
+
+class FrozenCircuit {
+    public:
+        /// Thrown by `sign` when asked for a level that was not precomputed
+        class LevelNotFrozen : public std::exception {};
+
+        /** Highest signature level precomputed, which is the highest level
+         * needed by `equals` and `find` */
+        static const int MAX_LEVEL;
+
+        /** Builds a snapshot of the hierarchy rooted at `source`, which is
+         * not altered. The snapshot's root has no ancestor: if `source` has
+         * one, its signatures of level above 0 may differ from `source`'s.
+         */
+        FrozenCircuit(CircuitGroup* source);
+
+        /// Deletes the snapshot's hierarchy
+        ~FrozenCircuit();
+
+        FrozenCircuit(const FrozenCircuit&) = delete;
+        FrozenCircuit& operator=(const FrozenCircuit&) = delete;
+
+        /** Get the root of the snapshot. It must only be read through const
+         * methods, which do not alter it. */
+        const CircuitGroup* root() const { return root_; }
+
+        /** Signature of the snapshot's root, as `CircuitTree::sign`.
+         * @throw LevelNotFrozen if `level` is not in `[0, MAX_LEVEL]`. */
+        sign_t sign(int level=2) const;
+
+        /** Checks whether this snapshot is formally equal to `oth`, as
+         * `CircuitTree::equals`. */
+        bool equals(const FrozenCircuit& oth) const;
+
+        /** Finds every match of `needle` in this snapshot, as
+         * `CircuitGroup::find`. The results refer to the circuits and wires
+         * of this snapshot; see `original` to map them back. */
+        std::vector<MatchResult> find(const FrozenCircuit& needle) const;
+
+        /** Get the circuit of the original hierarchy copied as `circ`, or
+         * `nullptr` if `circ` does not belong to this snapshot. Valid as long
+         * as the original circuit lives. */
+        CircuitTree* original(const CircuitTree* circ) const;
+
+        /// Idem with a wire of this snapshot
+        WireId* original(const WireId* wire) const;
+
+    private:
+        /** Copies the unique wires of `source` into `copy`, returning the
+         * copies indexed by wire id */
+        std::vector<WireId*> copyWires(CircuitGroup* source,
+                CircuitGroup* copy);
+
+        /** Copies the children of `source` into `copy`, whose wires are
+         * given by `wires` (see `copyWires`) */
+        void copyChildren(CircuitGroup* source, CircuitGroup* copy,
+                const std::vector<WireId*>& wires);
+
+        /// Computes all the lazily computed state of the snapshot
+        void freeze();
+
+        CircuitGroup* root_;
+
+        std::unordered_map<const CircuitTree*, CircuitTree*> origCircs;
+        std::unordered_map<const WireId*, WireId*> origWires;
+};
@@ -1,6 +1,7 @@
 #include "gateExpression.h"
 #include <exception>
 #include <stdexcept>
+#include <unordered_set>
 
 using namespace signatureConstants;
 
@@ -79,11 +80,148 @@ static const OperConstants& cstOf(expr::ExpressionUnOperatorCst op) {
     throw UnimplementedOperator();
 }
 
-sign_t ExpressionConst::sign() const {
+// ======== Hash-consing ========
+
+struct ExpressionHashConsHash {
+    size_t operator()(const ExpressionBase* expr) const {
+        return SignHash()(expr->sign());
+    }
+};
+
+struct ExpressionHashConsEq {
+    bool operator()(const ExpressionBase* e1, const ExpressionBase* e2) const
+    {
+        return e1->type == e2->type && e1->shallowEqual(*e2);
+    }
+};
+
+typedef std::unordered_set<ExpressionBase*,
+        ExpressionHashConsHash, ExpressionHashConsEq> HashConsTable;
+
+/** The hash-consing table. Never freed, so that expressions outliving static
+ * destruction can still be released safely. */
+static HashConsTable& hashConsTable() {
+    static HashConsTable* table = new HashConsTable;
+    return *table;
+}
+
+/** Checks whether every direct sub-expression of `expr` is hash-consed. Only
+ * then can `expr` be hash-consed itself, since the table compares
+ * sub-expressions by pointer. */
+static bool subExprsInterned(const ExpressionBase* expr) {
+    switch(expr->type) {
+        case expr::ExprVar:
+        case expr::ExprConst:
+        case expr::ExprLongConst:
+            return true;
+        case expr::ExprBinOp: {
+            const ExpressionBinOp* e =
+                static_cast<const ExpressionBinOp*>(expr);
+            return e->left->isInterned() && e->right->isInterned();
+        }
+        case expr::ExprUnOp:
+            return static_cast<const ExpressionUnOp*>(expr)
+                ->expr->isInterned();
+        case expr::ExprUnOpCst:
+            return static_cast<const ExpressionUnOpCst*>(expr)
+                ->expr->isInterned();
+        case expr::ExprSlice:
+            return static_cast<const ExpressionSlice*>(expr)
+                ->expr->isInterned();
+        case expr::ExprMerge: {
+            const ExpressionMerge* e =
+                static_cast<const ExpressionMerge*>(expr);
+            return e->left->isInterned() && e->right->isInterned();
+        }
+    }
+    throw UnimplementedOperator();
+}
+
+ExpressionBase* ExpressionBase::intern(ExpressionBase* fresh) {
+    if(!subExprsInterned(fresh))
+        return fresh;
+
+    HashConsTable& table = hashConsTable();
+    auto found = table.find(fresh);
+    if(found != table.end()) {
+        delete fresh; // never referenced
+        return *found;
+    }
+    fresh->interned = true;
+    table.insert(fresh);
+    return fresh;
+}
+
+size_t ExpressionBase::internedCount() {
+    return hashConsTable().size();
+}
+
+void ExpressionBase::deleteSelf() {
+    refcount--;
+    if(refcount == 0) {
+        if(interned)
+            hashConsTable().erase(this);
+        delete this;
+    }
+}
+
+ExpressionConst* ExpressionConst::make(unsigned val) {
+    return static_cast<ExpressionConst*>(intern(new ExpressionConst(val)));
+}
+
+ExpressionLongConst* ExpressionLongConst::make(const std::string& val) {
+    return static_cast<ExpressionLongConst*>(
+            intern(new ExpressionLongConst(val)));
+}
+
+ExpressionVar* ExpressionVar::make(int id) {
+    return static_cast<ExpressionVar*>(intern(new ExpressionVar(id)));
+}
+
+ExpressionBinOp* ExpressionBinOp::make(ExpressionBase* left,
+        ExpressionBase* right,
+        expr::ExpressionBinOperator op)
+{
+    return static_cast<ExpressionBinOp*>(
+            intern(new ExpressionBinOp(left, right, op)));
+}
+
+ExpressionUnOp* ExpressionUnOp::make(ExpressionBase* expr,
+        expr::ExpressionUnOperator op)
+{
+    return static_cast<ExpressionUnOp*>(
+            intern(new ExpressionUnOp(expr, op)));
+}
+
+ExpressionUnOpCst* ExpressionUnOpCst::make(ExpressionBase* expr,
+        int val,
+        expr::ExpressionUnOperatorCst op)
+{
+    return static_cast<ExpressionUnOpCst*>(
+            intern(new ExpressionUnOpCst(expr, val, op)));
+}
+
+ExpressionSlice* ExpressionSlice::make(ExpressionBase* expr,
+        unsigned beg, unsigned end)
+{
+    return static_cast<ExpressionSlice*>(
+            intern(new ExpressionSlice(expr, beg, end)));
+}
+
+ExpressionMerge* ExpressionMerge::make(ExpressionBase* left,
+        ExpressionBase* right)
+{
+    return static_cast<ExpressionMerge*>(
+            intern(new ExpressionMerge(left, right)));
+}
+
+// ======== Signatures ========
+
+sign_t ExpressionConst::computeSign() const {
     return opcst_numconst(val);
 }
 
-sign_t ExpressionLongConst::sign() const {
+sign_t ExpressionLongConst::computeSign() const {
     uint32_t hashed = 0;
     for(size_t pos=0; pos < val.size(); pos += 16) {
         uint32_t cVal = 0;
@@ -106,81 +244,124 @@ sign_t ExpressionLongConst::sign() const {
     return opcst_longconst(hashed);
 }
 
-sign_t ExpressionVar::sign() const {
+sign_t ExpressionVar::computeSign() const {
     return opcst_wireid(id);
 }
 
-sign_t ExpressionBinOp::sign() const {
+sign_t ExpressionBinOp::computeSign() const {
     if(isCommutative(op))
         return cstOf(op)(left->sign() + right->sign());
     return cstOf(op)(left->sign() - right->sign());
 }
 
-sign_t ExpressionUnOp::sign() const {
+sign_t ExpressionUnOp::computeSign() const {
     return cstOf(op)(expr->sign());
 }
 
-sign_t ExpressionUnOpCst::sign() const {
+sign_t ExpressionUnOpCst::computeSign() const {
     return cstOf(op)(expr->sign() - opcst_cstint(val));
 }
 
-sign_t ExpressionSlice::sign() const {
+sign_t ExpressionSlice::computeSign() const {
     return opcst_slice(expr->sign()
             - opcst_slicebounds(end * sliceMulInner - beg));
 }
 
-sign_t ExpressionMerge::sign() const {
+sign_t ExpressionMerge::computeSign() const {
     return opcst_merge(left->sign() - right->sign());
 }
 
 bool ExpressionBase::equals(const ExpressionBase& oth) const {
+    if(this == &oth)
+        return true;
+    if(interned && oth.interned) // Hash-consed: equal iff same node
+        return false;
     if(type != oth.type)
         return false;
     return innerEqual(oth);
 }
 
 bool ExpressionConst::innerEqual(const ExpressionBase& oth) const {
-    const ExpressionConst& o = dynamic_cast<const ExpressionConst&>(oth);
+    const ExpressionConst& o = static_cast<const ExpressionConst&>(oth);
     return val == o.val;
 }
 
 bool ExpressionLongConst::innerEqual(const ExpressionBase& oth) const {
     const ExpressionLongConst& o =
-        dynamic_cast<const ExpressionLongConst&>(oth);
+        static_cast<const ExpressionLongConst&>(oth);
     return val == o.val;
 }
 
 bool ExpressionVar::innerEqual(const ExpressionBase& oth) const {
-    const ExpressionVar& o = dynamic_cast<const ExpressionVar&>(oth);
+    const ExpressionVar& o = static_cast<const ExpressionVar&>(oth);
     return id == o.id;
 }
 
 bool ExpressionBinOp::innerEqual(const ExpressionBase& oth) const {
-    const ExpressionBinOp& o = dynamic_cast<const ExpressionBinOp&>(oth);
+    const ExpressionBinOp& o = static_cast<const ExpressionBinOp&>(oth);
     return op == o.op
         && left->equals(*o.left)
         && right->equals(*o.right);
 }
 
 bool ExpressionUnOp::innerEqual(const ExpressionBase& oth) const {
-    const ExpressionUnOp& o = dynamic_cast<const ExpressionUnOp&>(oth);
+    const ExpressionUnOp& o = static_cast<const ExpressionUnOp&>(oth);
     return op == o.op
         && expr->equals(*o.expr);
 }
 
 bool ExpressionUnOpCst::innerEqual(const ExpressionBase& oth) const {
-    const ExpressionUnOpCst& o = dynamic_cast<const ExpressionUnOpCst&>(oth);
+    const ExpressionUnOpCst& o = static_cast<const ExpressionUnOpCst&>(oth);
     return op == o.op
         && val == o.val
         && expr->equals(*o.expr);
 }
 
 bool ExpressionSlice::innerEqual(const ExpressionBase& oth) const {
-    const ExpressionSlice& o = dynamic_cast<const ExpressionSlice&>(oth);
+    const ExpressionSlice& o = static_cast<const ExpressionSlice&>(oth);
     return beg == o.beg && end == o.end && expr->equals(*o.expr);
 }
 
 bool ExpressionMerge::innerEqual(const ExpressionBase& oth) const {
-    const ExpressionMerge& o = dynamic_cast<const ExpressionMerge&>(oth);
+    const ExpressionMerge& o = static_cast<const ExpressionMerge&>(oth);
     return left->equals(*o.left) && right->equals(*o.right);
 }
+
+// ======== Shallow equality (hash-consing) ========
+
+bool ExpressionConst::shallowEqual(const ExpressionBase& oth) const {
+    return val == static_cast<const ExpressionConst&>(oth).val;
+}
+
+bool ExpressionLongConst::shallowEqual(const ExpressionBase& oth) const {
+    return val == static_cast<const ExpressionLongConst&>(oth).val;
+}
+
+bool ExpressionVar::shallowEqual(const ExpressionBase& oth) const {
+    return id == static_cast<const ExpressionVar&>(oth).id;
+}
+
+bool ExpressionBinOp::shallowEqual(const ExpressionBase& oth) const {
+    const ExpressionBinOp& o = static_cast<const ExpressionBinOp&>(oth);
+    return op == o.op && left == o.left && right == o.right;
+}
+
+bool ExpressionUnOp::shallowEqual(const ExpressionBase& oth) const {
+    const ExpressionUnOp& o = static_cast<const ExpressionUnOp&>(oth);
+    return op == o.op && expr == o.expr;
+}
+
+bool ExpressionUnOpCst::shallowEqual(const ExpressionBase& oth) const {
+    const ExpressionUnOpCst& o = static_cast<const ExpressionUnOpCst&>(oth);
+    return op == o.op && val == o.val && expr == o.expr;
+}
+
+bool ExpressionSlice::shallowEqual(const ExpressionBase& oth) const {
+    const ExpressionSlice& o = static_cast<const ExpressionSlice&>(oth);
+    return beg == o.beg && end == o.end && expr == o.expr;
+}
+
+bool ExpressionMerge::shallowEqual(const ExpressionBase& oth) const {
+    const ExpressionMerge& o = static_cast<const ExpressionMerge&>(oth);
+    return left == o.left && right == o.right;
+}
@@ -57,17 +57,30 @@ namespace expr {
 
 class BadHex : public std::exception {};
 
-/** Base expression type, inherited by every "real" expression type */
+/** Base expression type, inherited by every "real" expression type
+ *
+ * Expressions should be built through the static `make` functions of each
+ * expression type, which hash-cons them: structurally identical expressions
+ * built this way share the same node, and can thus be compared by pointer.
+ * An expression must not be altered once it was built.
+ */
 struct ExpressionBase {
     ExpressionBase(const expr::ExpressionType& type)
-        : type(type), refcount(0) {}
+        : type(type), refcount(0), interned(false), sigMemoized(false) {}
     virtual ~ExpressionBase() {}
     expr::ExpressionType type;    ///< Type of the expression (used for casts)
 
-    /** Compute a signature for this expression */
-    virtual sign_t sign() const = 0; // FIXME memoize?
+    /** Compute a signature for this expression. Memoized function. */
+    sign_t sign() const {
+        if(!sigMemoized) {
+            memoSig = computeSign();
+            sigMemoized = true;
+        }
+        return memoSig;
+    }
 
-    /** Check whether two experessions are formally equal */
+    /** Check whether two experessions are formally equal. This is a pointer
+     * comparison if both expressions are hash-consed. */
     bool equals(const ExpressionBase& oth) const;
 
     /// The object is referenced somewhere
@@ -76,17 +89,36 @@ struct ExpressionBase {
     }
 
     /// Call this instead of `delete`
-    void deleteSelf() {
-        refcount--;
-        if(refcount == 0)
-            delete this;
-    }
+    void deleteSelf();
+
+    /// Checks whether this expression is hash-consed
+    bool isInterned() const { return interned; }
+
+    /** Returns the hash-consed node structurally equal to `fresh`, which
+     * must have been freshly allocated and never referenced. If such a node
+     * already exists, `fresh` is deleted. If some sub-expression of `fresh`
+     * is not hash-consed, `fresh` is returned as-is. */
+    static ExpressionBase* intern(ExpressionBase* fresh);
+
+    /// Number of hash-consed expressions currently alive
+    static size_t internedCount();
 
     private:
+        virtual sign_t computeSign() const = 0;
         virtual bool innerEqual(const ExpressionBase& oth) const = 0;
 
+        /** Checks that `oth`, of the same type, has the same fields and the
+         * very same sub-expression pointers. */
+        virtual bool shallowEqual(const ExpressionBase& oth) const = 0;
+
+        friend struct ExpressionHashConsEq;
+
     protected:
         int refcount;
+        bool interned;
+
+        mutable bool sigMemoized;
+        mutable sign_t memoSig;
 };
 
 /** Integer constant (`ExprConst`) */
@@ -96,16 +128,19 @@ struct ExpressionConst : ExpressionBase {
 
     unsigned val;           ///< Numeric value
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionConst* make(unsigned val);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
 
 /** Integer long constant (`ExprLongConst`) */
 struct ExpressionLongConst : ExpressionBase {
     ExpressionLongConst(const std::string& val)
-        : ExpressionBase(expr::ExprConst), val(val)
+        : ExpressionBase(expr::ExprLongConst), val(val)
     {
         for(const auto& ch: this->val) {
             if(!('0' <= ch && ch <= '9')
@@ -117,10 +152,13 @@ struct ExpressionLongConst : ExpressionBase {
 
     std::string val;           ///< Numeric value
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionLongConst* make(const std::string& val);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
 
 /** End variable expression (`ExprVar`) */
@@ -129,10 +167,13 @@ struct ExpressionVar : ExpressionBase {
 
     int id;                 ///< Id of the input pin referred
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionVar* make(int id);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
 
 /** Binary operator expression (`ExprBinOp`) */
@@ -153,10 +194,15 @@ struct ExpressionBinOp : public ExpressionBase {
     ExpressionBase *left, *right;
     expr::ExpressionBinOperator op;       ///< Operator
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionBinOp* make(ExpressionBase* left,
+            ExpressionBase* right,
+            expr::ExpressionBinOperator op);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
 
 /** Unary operator expression (`ExprUnOp`) */
@@ -173,10 +219,14 @@ struct ExpressionUnOp : ExpressionBase {
     ExpressionBase *expr;           ///< Sub-expression
     expr::ExpressionUnOperator op;  ///< Operator
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionUnOp* make(ExpressionBase* expr,
+            expr::ExpressionUnOperator op);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
 
 /** Unary operator with constant (`ExprUnOpCst`) */
@@ -196,10 +246,15 @@ struct ExpressionUnOpCst : ExpressionBase {
     int val;                            ///< Constant associated
     expr::ExpressionUnOperatorCst op;   ///< Operator
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionUnOpCst* make(ExpressionBase* expr,
+            int val,
+            expr::ExpressionUnOperatorCst op);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
 
 /** Take a subword out of a word (`ExprSlice`) */
@@ -217,10 +272,14 @@ struct ExpressionSlice : ExpressionBase {
     unsigned beg;           ///< First index (inclusive) of the subword
     unsigned end;           ///< Last index (exclusive) of the subword
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionSlice* make(ExpressionBase* expr,
+            unsigned beg, unsigned end);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
 
 /** Concatenate two words (`ExprMerge`) */
@@ -238,8 +297,12 @@ struct ExpressionMerge : ExpressionBase {
 
     ExpressionBase *left, *right;
 
-    virtual sign_t sign() const;
+    /// Hash-consed constructor
+    static ExpressionMerge* make(ExpressionBase* left,
+            ExpressionBase* right);
 
     private:
+        virtual sign_t computeSign() const;
         virtual bool innerEqual(const ExpressionBase& oth) const;
+        virtual bool shallowEqual(const ExpressionBase& oth) const;
 };
@@ -5,6 +5,8 @@
 
 #include "debug.h"
 #include "circuitGroup.h"
+#include "searchBudget.h"
+#include "sigStats.h"
 
 using namespace std;
 
@@ -42,10 +44,12 @@ namespace groupEquality {
     }
 
     int factorial(int k) {
-        static vector<int> memoized {1, 1};
-        for(int nextVal = (int)memoized.size(); nextVal <= k; ++nextVal)
-            memoized.push_back(memoized.back() * nextVal);
-        return memoized[k];
+        // Not memoized: `equal` must not write any shared state, see
+        // `FrozenCircuit`
+        int out = 1;
+        for(int val = 2; val <= k; ++val)
+            out *= val;
+        return out;
     }
 
     sign_t wireSignature(WireId* wire, int accuracy) {
@@ -122,9 +126,11 @@ namespace groupEquality {
         for(size_t pos = 0 ; pos < leftSplit.size(); ++pos) {
             const vector<int>& curPerm = perm[pos];
             for(size_t circId = 0; circId < leftSplit[pos].size(); ++circId) {
+                SIG_STAT_INC(equalChecks);
                 if(!leftSplit[pos][circId]->equals(
                             rightSplit[pos][curPerm[circId]]))
                 {
+                    SIG_STAT_INC(equalCollisions);
                     EQ_DEBUG("Not sub-equal (types %d, %d)\n",
                             leftSplit[pos][circId]->circType(),
                             rightSplit[pos][curPerm[circId]]->circType());
@@ -149,32 +155,26 @@ namespace groupEquality {
             for(size_t circId = 0; circId < leftSplit[pos].size(); ++circId) {
                 CircuitTree *left = leftSplit[pos][circId],
                     *right = rightSplit[pos][curPerm[circId]];
-                CircuitTree::IoIter lWire = left->io_begin(),
-                    rWire = right->io_begin();
-                for(; lWire != left->io_end() /* rWire checked after */ ;
-                        ++lWire, ++rWire)
-                {
-                    if(rWire == right->io_end()) { // Prematurate end
-                        EQ_DEBUG("Bad wire count (<- %s)\n",
-                                (*lWire)->name().c_str());
-                        return false;
-                    }
-                    if(lrWireMap.find(*lWire) != lrWireMap.end()
-                            && *(lrWireMap[*lWire]) != **rWire)
+                WireSpan lWires = left->io_wires(),
+                         rWires = right->io_wires();
+                if(lWires.size() != rWires.size()) { // Bad wire count
+                    EQ_DEBUG("Bad wire count (%zu - %zu)\n",
+                            lWires.size(), rWires.size());
+                    return false;
+                }
+                for(size_t wirePos = 0; wirePos < lWires.size(); ++wirePos) {
+                    WireId *lWire = lWires[wirePos], *rWire = rWires[wirePos];
+                    auto mapped = lrWireMap.find(lWire);
+                    if(mapped != lrWireMap.end() && *(mapped->second) != *rWire)
                     {
                         EQ_DEBUG("Wire conflict %s -> {%s - %s}\n",
-                                (*lWire)->uniqueName().c_str(),
-                                lrWireMap.find(*lWire)->second->uniqueName().c_str(),
-                                (*rWire)->uniqueName().c_str());
+                                lWire->uniqueName().c_str(),
+                                mapped->second->uniqueName().c_str(),
+                                rWire->uniqueName().c_str());
                         return false; // Wire conflict
                     }
 
-                    lrWireMap[*lWire] = *rWire;
-                }
-                if(rWire != right->io_end()) { // Bad wire count
-                    EQ_DEBUG("Bad wire count (-> %s)\n",
-                            (*rWire)->name().c_str());
-                    return false;
+                    lrWireMap[lWire] = rWire;
                 }
             }
         }
@@ -193,7 +193,6 @@ namespace groupEquality {
     bool equal(CircuitGroup* left, CircuitGroup* right) {
         // FIXME obscure constants
         const int BASE_PRECISION = 2,
-              MAX_PRECISION = 15,
               MAX_PERMUTATIONS = 4;
 
         EQ_DEBUG("\t> Entering %s <\n", left->name().c_str());
@@ -258,12 +257,18 @@ namespace groupEquality {
 
             groupEquality::Permutation perm(leftSplit);
             do {
+                if(!SearchBudget::spend()) {
+                    EQ_DEBUG(">> Out of budget (%s)\n", left->name().c_str());
+                    return false;
+                }
+                SIG_STAT_INC(permutationsTried);
                 if(groupEquality::equalWithPermutation(
                             leftSplit, rightSplit, perm))
                 {
                     EQ_DEBUG(">> Permutation (%s) OK\n", left->name().c_str());
                     return true;
                 }
+                SIG_STAT_INC(permutationsFailed);
             } while(perm.next());
             EQ_DEBUG(">> No permutation worked :c (%s)\n",
                     left->name().c_str());
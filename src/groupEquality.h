@@ -11,7 +11,12 @@
 
 namespace groupEquality {
     typedef std::vector<std::vector<CircuitTree*> > SigSplit;
-    typedef std::unordered_map<sign_t, std::set<CircuitTree*> > SigSplitMapped;
+    typedef std::unordered_map<sign_t, std::set<CircuitTree*>, SignHash>
+        SigSplitMapped;
+
+    /** Highest signature level used by `equal`, at which every remaining
+     * permutation is tried */
+    const int MAX_PRECISION = 15;
 
     class TooManyPermutations : public std::exception {};
 
@@ -67,5 +72,7 @@ namespace groupEquality {
             const SigSplit& leftSplit, const SigSplit& rightSplit,
             const Permutation& perm);
 
+    /** Checks whether `left` and `right` are formally equal. Returns `false`
+     * if the active `SearchBudget` runs out before an answer is found. */
     bool equal(CircuitGroup* left, CircuitGroup* right);
 }
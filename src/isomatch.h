@@ -1,11 +1,19 @@
 #pragma once
 
+#include "batchSign.h"
 #include "circuitAssert.h"
 #include "circuitComb.h"
 #include "circuitDelay.h"
 #include "circuitGroup.h"
 #include "circuitTree.h"
 #include "circuitTristate.h"
+#include "flatNetlist.h"
+#include "frozenCircuit.h"
 #include "gateExpression.h"
+#include "leafStore.h"
+#include "nameInterner.h"
+#include "netIndex.h"
+#include "searchBudget.h"
+#include "sigStats.h"
 #include "wireId.h"
 #include "wireManager.h"
@@ -0,0 +1,118 @@
+#include "leafStore.h"
+#include "circuitAssert.h"
+#include "circuitComb.h"
+#include "gateExpression.h"
+
+using namespace std;
+
+void LeafStore::build(const std::vector<CircuitTree*>& children) {
+    types.clear();
+    circuits.clear();
+    ioOffsets.assign(1, 0);
+    inputCounts.clear();
+    wires.clear();
+    exprOffsets.assign(1, 0);
+    exprs.clear();
+
+    for(auto child: children) {
+        CircuitTree::CircType type = child->circType();
+        types.push_back(type);
+        circuits.push_back(child);
+
+        if(type != CircuitTree::CIRC_GROUP) {
+            WireSpan childIo = child->io_wires();
+            wires.insert(wires.end(), childIo.begin(), childIo.end());
+            inputCounts.push_back(child->inp_wires().size());
+        }
+        else
+            inputCounts.push_back(0);
+        ioOffsets.push_back(wires.size());
+
+        switch(type) {
+            case CircuitTree::CIRC_COMB: {
+                const auto& combExprs =
+                    static_cast<CircuitComb*>(child)->expressions();
+                exprs.insert(exprs.end(), combExprs.begin(), combExprs.end());
+                break;
+            }
+            case CircuitTree::CIRC_ASSERT:
+                exprs.push_back(const_cast<ExpressionBase*>(
+                            static_cast<CircuitAssert*>(child)->expression()));
+                break;
+            default:
+                break;
+        }
+        exprOffsets.push_back(exprs.size());
+    }
+}
+
+sign_t LeafStore::innerSignatureKey(size_t pos) const {
+    switch(types[pos]) {
+        case CircuitTree::CIRC_COMB:
+            return combKey(inputCounts[pos],
+                    ioOffsets[pos + 1] - ioOffsets[pos] - inputCounts[pos],
+                    exprs.data() + exprOffsets[pos],
+                    exprOffsets[pos + 1] - exprOffsets[pos]);
+        case CircuitTree::CIRC_ASSERT:
+            return assertKey(inputCounts[pos], exprs[exprOffsets[pos]]);
+        case CircuitTree::CIRC_DELAY:
+        case CircuitTree::CIRC_TRI:
+            return wireGateKey(types[pos]);
+        case CircuitTree::CIRC_GROUP:
+            break;
+    }
+    return 0; // Not a leaf
+}
+
+bool LeafStore::equals(size_t pos, const LeafStore& oth, size_t othPos) const
+{
+    if(types[pos] != oth.types[othPos])
+        return false;
+
+    switch(types[pos]) {
+        case CircuitTree::CIRC_COMB:
+        case CircuitTree::CIRC_ASSERT: {
+            size_t exprCount = exprOffsets[pos + 1] - exprOffsets[pos];
+            if(inputCounts[pos] != oth.inputCounts[othPos]
+                    || ioOffsets[pos + 1] - ioOffsets[pos]
+                        != oth.ioOffsets[othPos + 1] - oth.ioOffsets[othPos]
+                    || exprCount
+                        != oth.exprOffsets[othPos + 1] - oth.exprOffsets[othPos])
+                return false;
+            for(size_t expr = 0; expr < exprCount; ++expr) {
+                if(!exprs[exprOffsets[pos] + expr]->equals(
+                            *oth.exprs[oth.exprOffsets[othPos] + expr]))
+                    return false;
+            }
+            return true;
+        }
+        case CircuitTree::CIRC_DELAY:
+        case CircuitTree::CIRC_TRI:
+            return true; // No inner data
+        case CircuitTree::CIRC_GROUP:
+            break;
+    }
+    return circuits[pos]->equals(oth.circuits[othPos]);
+}
+
+sign_t LeafStore::combKey(size_t inputs, size_t outputs,
+        ExpressionBase* const* exprs, size_t exprCount)
+{
+    sign_t exprsSum = 0;
+    for(size_t expr = 0; expr < exprCount; ++expr)
+        exprsSum ^= exprs[expr]->sign();
+
+    return ((CircuitTree::CIRC_COMB << 16)
+            | (inputs << 8)
+            | outputs)
+        ^ exprsSum;
+}
+
+sign_t LeafStore::assertKey(size_t inputs, const ExpressionBase* expr) {
+    return ((CircuitTree::CIRC_ASSERT << 16) | (inputs << 8))
+        + expr->sign();
+}
+
+sign_t LeafStore::wireGateKey(CircuitTree::CircType type) {
+    return (type << 16) + (1 << 8) + 1;
+}
@@ -0,0 +1,86 @@
+/** Compact, type-tagged store of the children of a group.
+ *
+ * A `LeafStore` mirrors the children of a `CircuitGroup` as a
+ * struct-of-arrays: a type tag per child, and its I/O wires and expressions
+ * packed in flat arrays. The signature and equality kernels of leaf gates
+ * work on these arrays through a `switch` on the type tag, instead of
+ * virtual calls and `dynamic_cast`s on each gate.
+ *
+ * The children keep being regular `CircuitTree` objects, which are the
+ * "view" through which the rest of the library accesses them. The store is
+ * built lazily by `CircuitGroup::leafStore`, and rebuilt whenever the group
+ * is altered.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "circuitTree.h"
+
+class ExpressionBase;
+
+class LeafStore {
+    public:
+        LeafStore() {}
+
+        /// Fills the store with `children`, replacing its previous contents
+        void build(const std::vector<CircuitTree*>& children);
+
+        /// Number of children stored
+        size_t size() const { return types.size(); }
+
+        /// Type of the `pos`-th child
+        CircuitTree::CircType type(size_t pos) const { return types[pos]; }
+
+        /// Checks whether the `pos`-th child is a leaf gate (not a group)
+        bool isLeaf(size_t pos) const {
+            return types[pos] != CircuitTree::CIRC_GROUP;
+        }
+
+        /// `CircuitTree` view of the `pos`-th child
+        CircuitTree* circuit(size_t pos) const { return circuits[pos]; }
+
+        /// I/O wires of the `pos`-th child, inputs first
+        WireSpan io_wires(size_t pos) const {
+            return WireSpan(wires.data() + ioOffsets[pos],
+                    wires.data() + ioOffsets[pos + 1]);
+        }
+
+        /// Input wires of the `pos`-th child
+        WireSpan inp_wires(size_t pos) const {
+            return WireSpan(wires.data() + ioOffsets[pos],
+                    wires.data() + ioOffsets[pos] + inputCounts[pos]);
+        }
+
+        /** Inner signature key (see `CircuitTree::innerSignatureKey`) of the
+         * `pos`-th child, which must be a leaf. */
+        sign_t innerSignatureKey(size_t pos) const;
+
+        /** Formal equality of the `pos`-th leaf of this store and the
+         * `othPos`-th leaf of `oth`, as `CircuitTree::equals` */
+        bool equals(size_t pos, const LeafStore& oth, size_t othPos) const;
+
+        /// Inner signature key of a `CircuitComb`
+        static sign_t combKey(size_t inputs, size_t outputs,
+                ExpressionBase* const* exprs, size_t exprCount);
+
+        /// Inner signature key of a `CircuitAssert`
+        static sign_t assertKey(size_t inputs, const ExpressionBase* expr);
+
+        /// Inner signature key of a `CircuitDelay` or a `CircuitTristate`
+        static sign_t wireGateKey(CircuitTree::CircType type);
+
+    private:
+        std::vector<CircuitTree::CircType> types;
+        std::vector<CircuitTree*> circuits;
+
+        /// The `i`-th child's wires lie in `wires[ioOffsets[i]:ioOffsets[i+1]]`
+        std::vector<size_t> ioOffsets;
+        std::vector<size_t> inputCounts;
+        std::vector<WireId*> wires;
+
+        /// Idem with expressions
+        std::vector<size_t> exprOffsets;
+        std::vector<ExpressionBase*> exprs;
+};
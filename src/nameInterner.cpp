@@ -0,0 +1,106 @@
+#include "nameInterner.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+namespace {
+    /// Hashes an interned string through its pointer
+    struct HashStrPtr {
+        size_t operator()(const string* str) const {
+            return hash<string>()(*str);
+        }
+    };
+    struct EqualStrPtr {
+        bool operator()(const string* lhs, const string* rhs) const {
+            return *lhs == *rhs;
+        }
+    };
+
+    /// An interned string and its reference count
+    struct Entry {
+        string str;
+        size_t refs;
+    };
+
+    struct Interner {
+        /** The interned strings, indexed by id. A `deque` never moves its
+         * elements when growing. */
+        deque<Entry> entries;
+        /// Ids of the freed entries, to be reused
+        vector<name_id_t> freeIds;
+        /// Maps every live string of `entries` to its id
+        unordered_map<const string*, name_id_t, HashStrPtr, EqualStrPtr> ids;
+        /// Guards all of the above
+        mutex lock;
+    };
+
+    Interner& interner() {
+        static Interner interner;
+        return interner;
+    }
+}
+
+namespace nameInterner {
+    name_id_t intern(const std::string& name) {
+        Interner& inter = interner();
+        lock_guard<mutex> guard(inter.lock);
+        auto found = inter.ids.find(&name);
+        if(found != inter.ids.end()) {
+            ++inter.entries[found->second].refs;
+            return found->second;
+        }
+
+        name_id_t id;
+        if(inter.freeIds.empty()) {
+            id = inter.entries.size();
+            inter.entries.emplace_back();
+        }
+        else {
+            id = inter.freeIds.back();
+            inter.freeIds.pop_back();
+        }
+        Entry& entry = inter.entries[id];
+        entry.str = name;
+        entry.refs = 1;
+        inter.ids[&entry.str] = id;
+        return id;
+    }
+
+    void release(name_id_t id) {
+        if(id == NO_NAME)
+            return;
+        Interner& inter = interner();
+        lock_guard<mutex> guard(inter.lock);
+        Entry& entry = inter.entries[id];
+        if(--entry.refs > 0)
+            return;
+        inter.ids.erase(&entry.str);
+        string().swap(entry.str);
+        inter.freeIds.push_back(id);
+    }
+
+    bool lookup(const std::string& name, name_id_t& id) {
+        Interner& inter = interner();
+        lock_guard<mutex> guard(inter.lock);
+        auto found = inter.ids.find(&name);
+        if(found == inter.ids.end())
+            return false;
+        id = found->second;
+        return true;
+    }
+
+    const std::string& str(name_id_t id) {
+        Interner& inter = interner();
+        lock_guard<mutex> guard(inter.lock);
+        return inter.entries[id].str;
+    }
+
+    size_t size() {
+        Interner& inter = interner();
+        lock_guard<mutex> guard(inter.lock);
+        return inter.ids.size();
+    }
+}
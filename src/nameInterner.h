@@ -0,0 +1,44 @@
+/** Interning of the wire and circuit names.
+ *
+ * Every distinct name is stored once, globally, and referred to by a small
+ * integer id. Circuits and wire managers only store these ids: the names
+ * shared by many wires or groups (eg. `clk`, or the formal names of the pins
+ * of every instance of a group) are thus not duplicated.
+ *
+ * Interned names are reference counted: each call to `intern` must be
+ * balanced by a call to `release`, once the id is no longer used (eg. when
+ * the circuit or wire manager holding it is destroyed). A name is freed, and
+ * its id reused, when its last reference is released; until then, the
+ * reference returned by `str` stays valid. The interner is thread-safe.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/// Id of an interned name
+typedef uint32_t name_id_t;
+
+namespace nameInterner {
+    /// Id standing for "no name"
+    const name_id_t NO_NAME = UINT32_MAX;
+
+    /** Get the id of `name`, interning it if it was not yet. Takes a
+     * reference to the name, to be released with `release`. */
+    name_id_t intern(const std::string& name);
+
+    /// Releases a reference taken by `intern`. Ignores `NO_NAME`.
+    void release(name_id_t id);
+
+    /** Looks up the id of `name` without interning it nor taking a
+     * reference to it.
+     * @return `false` if `name` is not currently interned. */
+    bool lookup(const std::string& name, name_id_t& id);
+
+    /// Get the string of id `id`, which must be currently referenced
+    const std::string& str(name_id_t id);
+
+    /// Number of distinct names currently interned
+    size_t size();
+}
@@ -0,0 +1,113 @@
+#include "netIndex.h"
+#include "circuitGroup.h"
+
+using namespace std;
+
+const size_t NetIndex::NO_NET;
+
+void NetIndex::build(CircuitGroup* root) {
+    managerRange.clear();
+    ufParent.clear();
+
+    // Give every unique wire of the hierarchy a global index: the wires
+    // merged together are a single wire of the net
+    vector<CircuitGroup*> groups, toVisit(1, root);
+    vector<CircuitTree*> leaves;
+    while(!toVisit.empty()) {
+        CircuitGroup* group = toVisit.back();
+        toVisit.pop_back();
+        groups.push_back(group);
+        size_t wires = group->wireManager()->wires().size();
+        managerRange[group->wireManager()] = { ufParent.size(), wires };
+        for(size_t wire = 0; wire < wires; ++wire)
+            ufParent.push_back(ufParent.size());
+
+        for(auto child: group->getChildrenCst()) {
+            if(child->circType() == CircuitTree::CIRC_GROUP)
+                toVisit.push_back(static_cast<CircuitGroup*>(child));
+            else
+                leaves.push_back(child);
+        }
+    }
+
+    // Join the wires connected through I/O pins
+    for(const CircuitGroup* group: groups) {
+        for(const auto* pins: { &group->getInputs(), &group->getOutputs() }) {
+            for(auto pin: *pins) {
+                size_t formal = globalIndex(pin->formal()),
+                       actual = globalIndex(pin->actual());
+                if(formal != NO_NET && actual != NO_NET)
+                    ufParent[ufFind(formal)] = ufFind(actual);
+            }
+        }
+    }
+
+    // Dense net ids
+    wireNet.assign(ufParent.size(), NO_NET);
+    vector<size_t> rootNet(ufParent.size(), NO_NET);
+    size_t nets = 0;
+    for(size_t wire = 0; wire < ufParent.size(); ++wire) {
+        size_t root = ufFind(wire);
+        if(rootNet[root] == NO_NET)
+            rootNet[root] = nets++;
+        wireNet[wire] = rootNet[root];
+    }
+    vector<size_t>().swap(ufParent);
+
+    // Leaf gates of each net: count, then fill
+    netOffsets.assign(nets + 1, 0);
+    vector<size_t> lastGate(nets, NO_NET);
+    for(size_t leaf = 0; leaf < leaves.size(); ++leaf) {
+        for(auto wire: leaves[leaf]->io_wires()) {
+            size_t net = netOf(wire);
+            if(net != NO_NET && lastGate[net] != leaf) {
+                lastGate[net] = leaf;
+                ++netOffsets[net + 1];
+            }
+        }
+    }
+    for(size_t net = 0; net < nets; ++net)
+        netOffsets[net + 1] += netOffsets[net];
+
+    netGates.resize(netOffsets[nets]);
+    vector<size_t> fill(netOffsets.begin(), netOffsets.end() - 1);
+    lastGate.assign(nets, NO_NET);
+    for(size_t leaf = 0; leaf < leaves.size(); ++leaf) {
+        for(auto wire: leaves[leaf]->io_wires()) {
+            size_t net = netOf(wire);
+            if(net != NO_NET && lastGate[net] != leaf) {
+                lastGate[net] = leaf;
+                netGates[fill[net]++] = leaves[leaf];
+            }
+        }
+    }
+}
+
+size_t NetIndex::netOf(const WireId* wire) const {
+    size_t index = globalIndex(wire);
+    return index == NO_NET ? NO_NET : wireNet[index];
+}
+
+size_t NetIndex::globalIndex(const WireId* wire) const {
+    if(wire == nullptr)
+        return NO_NET;
+    auto range = managerRange.find(wire->manager());
+    if(range == managerRange.end())
+        return NO_NET;
+    size_t index = wire->manager()->uniqueIndex(wire);
+    if(index >= range->second.count)
+        return NO_NET;
+    return range->second.base + index;
+}
+
+size_t NetIndex::ufFind(size_t wire) {
+    size_t root = wire;
+    while(ufParent[root] != root)
+        root = ufParent[root];
+    while(ufParent[wire] != root) {
+        size_t next = ufParent[wire];
+        ufParent[wire] = root;
+        wire = next;
+    }
+    return root;
+}
@@ -0,0 +1,79 @@
+/** Flat index of the nets of a circuit hierarchy.
+ *
+ * A net is a set of wires, possibly spread across the groups of a hierarchy,
+ * that are connected together through the I/O pins of the groups. A
+ * `NetIndex` gives every wire of a hierarchy the global id of its net, and
+ * lists the leaf gates connected to each net, in a compressed sparse row
+ * form.
+ *
+ * It is built in a single pass over the hierarchy, and cached by
+ * `CircuitGroup::netIndex` until the hierarchy is altered.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "wireId.h"
+
+class CircuitTree;
+class CircuitGroup;
+class WireManager;
+
+class NetIndex {
+    public:
+        /// Id returned for the wires that do not belong to the hierarchy
+        static const size_t NO_NET = (size_t)-1;
+
+        NetIndex() : netOffsets(1, 0) {}
+
+        /** Indexes the hierarchy rooted at `root`, replacing any previous
+         * contents */
+        void build(CircuitGroup* root);
+
+        /// Number of distinct nets in the hierarchy
+        size_t netCount() const { return netOffsets.size() - 1; }
+
+        /** Get the id of the net `wire` belongs to, in `[0, netCount())`,
+         * or `NO_NET` if `wire` is not part of the indexed hierarchy, eg. if
+         * it was created after the index was built. */
+        size_t netOf(const WireId* wire) const;
+
+        /// Iterator over the leaf gates of a net, stored contiguously
+        typedef CircuitTree* const* GateIterator;
+
+        /// First leaf gate connected to the net `net`
+        GateIterator gates_begin(size_t net) const {
+            return netGates.data() + netOffsets[net];
+        }
+        /// Past-the-end of `gates_begin`
+        GateIterator gates_end(size_t net) const {
+            return netGates.data() + netOffsets[net + 1];
+        }
+
+    private:
+        /** Index of `wire` among the unique wires of the hierarchy, shared
+         * by the wires merged together, or `NO_NET` */
+        size_t globalIndex(const WireId* wire) const;
+
+        size_t ufFind(size_t wire);
+
+        /// Wires of a manager, among the unique wires of the hierarchy
+        struct ManagerRange {
+            size_t base;  ///< Global index of its first unique wire
+            size_t count; ///< Number of its unique wires when indexed
+        };
+        std::unordered_map<const WireManager*, ManagerRange> managerRange;
+
+        /// Net of every unique wire, indexed by global wire index
+        std::vector<size_t> wireNet;
+
+        /// Union-find over the global wire indices, used while building
+        std::vector<size_t> ufParent;
+
+        /** Leaf gates of each net, between `netOffsets[net]` and
+         * `netOffsets[net + 1]` */
+        std::vector<size_t> netOffsets;
+        std::vector<CircuitTree*> netGates;
+};
@@ -0,0 +1,33 @@
+#include "searchBudget.h"
+
+using namespace std;
+
+namespace {
+
+/// Number of charged nodes between two checks of the deadline
+const uint64_t CLOCK_PERIOD = 64;
+
+}
+
+thread_local SearchBudget* SearchBudget::active = nullptr;
+
+SearchBudget::SearchBudget(chrono::milliseconds time, uint64_t nodes)
+    : timeLimited(time.count() > 0), deadline(Clock::now() + time),
+    maxNodes(nodes), spentNodes(0), cancelled(false),
+    status_(Status::COMPLETE)
+{}
+
+bool SearchBudget::charge() {
+    if(status_ != Status::COMPLETE)
+        return false;
+
+    ++spentNodes;
+    if(cancelled.load(memory_order_relaxed))
+        status_ = Status::CANCELLED;
+    else if(maxNodes > 0 && spentNodes > maxNodes)
+        status_ = Status::EXHAUSTED;
+    else if(timeLimited && spentNodes % CLOCK_PERIOD == 0
+            && Clock::now() >= deadline)
+        status_ = Status::EXHAUSTED;
+    return status_ == Status::COMPLETE;
+}
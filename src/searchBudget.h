@@ -0,0 +1,99 @@
+/** Time and work budget of the searches, with cancellation.
+ *
+ * The subcircuit search (`matchSubcircuit`) and the group equality check
+ * (`groupEquality::equal`) may run for very long on some inputs, eg. a group
+ * with many identical children. A `SearchBudget` made active on the current
+ * thread through a `SearchBudget::Scope` bounds them: their search loops
+ * charge it, and stop as soon as it is spent, returning what they have found
+ * so far — a partial list of matches, or `false` for an equality check. Its
+ * `status` then tells those apart from complete results:
+ *
+ *     SearchBudget budget(std::chrono::milliseconds(500));
+ *     {
+ *         SearchBudget::Scope scope(budget);
+ *         matches = haystack->find(needle);
+ *     }
+ *     if(budget.status() != SearchBudget::Status::COMPLETE)
+ *         // `matches` is partial
+ *
+ * A budget is charged by one thread at a time; only `cancel` may be called
+ * from another thread.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+class SearchBudget {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        /// Outcome of the searches run within a budget
+        enum class Status {
+            COMPLETE,   ///< Never spent: the searches ran to their end
+            EXHAUSTED,  ///< The time or node budget ran out
+            CANCELLED   ///< Stopped by `cancel`
+        };
+
+        /** Budget of `time`, counted from now, and of `nodes` search nodes
+         * (eg. candidates tried by the subcircuit search, or permutations
+         * tried by the equality check). A zero value leaves the corresponding
+         * resource unbounded. */
+        explicit SearchBudget(
+                std::chrono::milliseconds time = std::chrono::milliseconds(0),
+                uint64_t nodes = 0);
+
+        SearchBudget(const SearchBudget&) = delete;
+        SearchBudget& operator=(const SearchBudget&) = delete;
+
+        /** Stops the searches running within this budget at their next
+         * check. Thread-safe. */
+        void cancel() { cancelled = true; }
+
+        /// Outcome of the searches run so far within this budget
+        Status status() const { return status_; }
+
+        /// Number of search nodes charged so far
+        uint64_t nodesSpent() const { return spentNodes; }
+
+        /** Charges one search node to the budget active on this thread, if
+         * any. Returns `false` if the search must stop. */
+        static bool spend() {
+            return active == nullptr || active->charge();
+        }
+
+        /// Checks whether the budget active on this thread, if any, is spent
+        static bool spent() {
+            return active != nullptr && active->status_ != Status::COMPLETE;
+        }
+
+        /** Makes a budget active on the current thread during its lifetime,
+         * in place of the previously active one, if any */
+        class Scope {
+            public:
+                explicit Scope(SearchBudget& budget) : previous(active) {
+                    active = &budget;
+                }
+                ~Scope() { active = previous; }
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+            private:
+                SearchBudget* previous;
+        };
+
+    private:
+        /// Charges one node, see `spend`
+        bool charge();
+
+        static thread_local SearchBudget* active;
+
+        bool timeLimited;
+        Clock::time_point deadline;
+        uint64_t maxNodes, spentNodes;
+        std::atomic<bool> cancelled;
+        Status status_;
+};
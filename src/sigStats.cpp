@@ -0,0 +1,17 @@
+#include "sigStats.h"
+
+namespace sigStats {
+    static Counters counters = {0, 0, 0, 0, 0, 0};
+
+    const Counters& get() {
+        return counters;
+    }
+
+    void reset() {
+        counters = Counters {0, 0, 0, 0, 0, 0};
+    }
+
+    Counters& mutableCounters() {
+        return counters;
+    }
+}
@@ -0,0 +1,49 @@
+/** Telemetry about signature collisions.
+ *
+ * Counts the costly formal equality checks performed on circuits that share
+ * the same signature, and how many of them turned out to be unequal. This
+ * quantifies the equality work wasted because of signature collisions.
+ *
+ * The counters are only updated when the library is compiled with
+ * `SIG_STATS` defined; otherwise, they always stay at 0.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace sigStats {
+    /// Collision counters
+    struct Counters {
+        /** Sub-equality checks, in `groupEquality`, between two circuits of
+         * the same signature */
+        size_t equalChecks;
+        /// Among `equalChecks`, the number of unequal circuits
+        size_t equalCollisions;
+
+        /// Children permutations tried by `groupEquality::equal`
+        size_t permutationsTried;
+        /// Among `permutationsTried`, the number of failed permutations
+        size_t permutationsFailed;
+
+        /// Candidate matches, found by signatures, checked by `find`
+        size_t matchChecks;
+        /// Among `matchChecks`, the number of candidates that did not match
+        size_t matchCollisions;
+    };
+
+    /// Get the current values of the counters
+    const Counters& get();
+
+    /// Resets every counter to 0
+    void reset();
+
+    /// Get the counters, mutable. Use `SIG_STAT_INC` instead.
+    Counters& mutableCounters();
+}
+
+#ifdef SIG_STATS
+#define SIG_STAT_INC(counter) (++sigStats::mutableCounters().counter)
+#else
+#define SIG_STAT_INC(counter) do {} while(false)
+#endif
@@ -1,14 +1,43 @@
 #include "signatureConstants.h"
+#include <ostream>
 
 namespace signatureConstants {
     typedef uint32_t u32;
     typedef uint64_t u64;
 
-    uint64_t OperConstants::operator()(uint64_t v) const {
+#ifndef SIGN_MIX_XORSHIFT
+    uint64_t OperConstants::mix64(uint64_t v) const {
         uint32_t b1 = v;
         uint64_t out1 = (u64)(b1 + add) * (u64)lowMul;
         uint32_t b2 = (v >> 32) ^ (out1 >> 32);
         return (u64)(out1 % lowMod)
             | ((u64)((b2 + add) * highMul % highMod) << 32);
     }
+#endif
+
+    sign_t OperConstants::operator()(sign_t v) const {
+#ifdef SIGN_128
+        // The high half is salted with the low half of `v`, itself mixed
+        // with other constants: otherwise, as most hashes fit in 64 bits,
+        // the high half would only depend on the signed low half.
+        u64 low = mix64((u64)v);
+        u64 high = mix64((u64)(v >> 64) ^ opcst_highhalf.mix64((u64)v));
+        return ((sign_t)high << 64) | low;
+#else
+        return mix64(v);
+#endif
+    }
+}
+
+#ifdef SIGN_128
+std::ostream& operator<<(std::ostream& out, sign_t sig) {
+    static const char* hexDigits = "0123456789abcdef";
+    char buffer[33];
+    buffer[32] = '\0';
+    for(int digit = 31; digit >= 0; --digit) {
+        buffer[digit] = hexDigits[sig & 0xf];
+        sig >>= 4;
+    }
+    return out << "0x" << buffer;
 }
+#endif
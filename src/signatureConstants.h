@@ -3,11 +3,61 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
+#include <iosfwd>
 
+#ifdef SIGN_128
+/// Type of a gate/expression signature (128 bits wide, see `SIGN_128`)
+typedef unsigned __int128 sign_t;
+
+/// Prints a 128-bit signature (as a hexadecimal number)
+std::ostream& operator<<(std::ostream& out, sign_t sig);
+#else
 /// Type of a gate/expression signature
 typedef uint64_t sign_t;
+#endif
+
+/// Hash functor for `sign_t`, to be used in unordered containers
+struct SignHash {
+    size_t operator()(sign_t sig) const {
+#ifdef SIGN_128
+        return (size_t)sig ^ (size_t)(sig >> 64);
+#else
+        return sig;
+#endif
+    }
+};
 
 namespace signatureConstants {
+#ifdef SIGN_MIX_XORSHIFT
+    /**
+     * Holds constants values and an evaluation function to sign a given hash
+     * with those values, using a multiply-xorshift mixing function (no
+     * integer division involved).
+     */
+    struct OperConstants {
+        OperConstants(uint64_t add, uint64_t mul1, uint64_t mul2) :
+            add(add), mul1(mul1), mul2(mul2) {}
+
+        uint64_t add;
+        uint64_t mul1, mul2;
+
+        /// Signs the hash
+        sign_t operator() (sign_t v) const;
+
+        private:
+            /// Signs a 64-bit hash
+            uint64_t mix64(uint64_t v) const {
+                v += add;
+                v ^= v >> 32;
+                v *= mul1;
+                v ^= v >> 29;
+                v *= mul2;
+                v ^= v >> 32;
+                return v;
+            }
+    };
+#else
     /**
      * Holds constants values and an evaluation function to sign a given hash
      * with those values.
@@ -23,13 +73,45 @@ namespace signatureConstants {
         uint32_t lowMod, highMod;
 
         /// Signs the hash
-        uint64_t operator() (uint64_t v) const;
+        sign_t operator() (sign_t v) const;
+
+        private:
+            /// Signs a 64-bit hash
+            uint64_t mix64(uint64_t v) const;
     };
+#endif
 
-    // ==== CONSTANTS ==== (Auto-generated)
+    // ==== CONSTANTS ==== (Auto-generated, see `util/primegen`)
     // ===================
     const uint32_t pinIdMod = 895948033;
     const uint32_t sliceMulInner = 166597;
+#ifdef SIGN_MIX_XORSHIFT
+    const OperConstants opcst_and(0x48a37a683c3a942bull, 0xd11600588ed94bb9ull, 0x99a7611697b362efull);
+    const OperConstants opcst_or(0xb4091434b7cb2f82ull, 0xf3d0d5f4253bda27ull, 0x9f13ec8f642104a1ull);
+    const OperConstants opcst_xor(0x1fe59ba5f503626full, 0xe10d1a920d3b874dull, 0x95ca04a9720edb43ull);
+    const OperConstants opcst_add(0xfd47dd12578ece2dull, 0xfc25f6b250caf311ull, 0xc761ffb96638ac65ull);
+    const OperConstants opcst_sub(0x75d3d5066f0d2231ull, 0x93ea16c91a91c05bull, 0x948fb18122e7ca7bull);
+    const OperConstants opcst_mul(0xeef52c2fc9e0fbc4ull, 0xf86411fe5383cc3dull, 0xc50fd609e2bb3983ull);
+    const OperConstants opcst_div(0xcbffe8757ce9f0fbull, 0xcb66a55293549fe3ull, 0xbf2ba5ac600515d9ull);
+    const OperConstants opcst_mod(0x73800e45a026bad3ull, 0xa91bc3f7a89c5681ull, 0x887c7d5c61ca68c5ull);
+    const OperConstants opcst_lsl(0x825ecc51dede6af6ull, 0xd4bd9f1954d2cad1ull, 0x80bbc2e577953abfull);
+    const OperConstants opcst_lsr(0xde1bb420b9c50a4eull, 0xf2c46a0ecfc91c93ull, 0xf1bb084079dae00bull);
+    const OperConstants opcst_asr(0x519c14a79151ce93ull, 0x83b44d8d15557ff9ull, 0xc2c217e43ee5dda5ull);
+    const OperConstants opcst_not(0xfaef49bbb13bd8b8ull, 0xe78a7a410279ad53ull, 0x98347c8de45c7a93ull);
+    const OperConstants opcst_un_lsr(0xed98a297ae6928c1ull, 0x9bf7e3986f1037a5ull, 0xe0e091c09fde3463ull);
+    const OperConstants opcst_un_lsl(0x92fb591d779ec5b3ull, 0x906a55267ce0450full, 0xdd6ce50ff9323705ull);
+    const OperConstants opcst_un_asr(0x695a6a65d6647d5bull, 0x848c5d4938d44fb9ull, 0xae2cb9471d7274e9ull);
+    const OperConstants opcst_cstint(0x6e108aa893405575ull, 0xf659172b44ef68d9ull, 0xac7283c3cafccc5dull);
+    const OperConstants opcst_wireid(0xc915b4a70f81eb7cull, 0xb98f12b7d226483full, 0xd3ca4859f31da87dull);
+    const OperConstants opcst_numconst(0x92f5ee93390ea14bull, 0xacfc3e986c985425ull, 0xb049cbe293ab8ba5ull);
+    const OperConstants opcst_longconst(0x37eac01f79568166ull, 0xbe4ab7e61f8d8605ull, 0xc4acf49bd4e69c2dull);
+    const OperConstants opcst_merge(0xd9fcd0a16dd7075bull, 0xc0d471e0b7997f99ull, 0xcd9d31c1cc1d9309ull);
+    const OperConstants opcst_slice(0x7cfa36be28a20c46ull, 0x948580f45fd430e9ull, 0xab3a391c30a95e79ull);
+    const OperConstants opcst_slicebounds(0x281e420240898295ull, 0xdbb8efa44c12dd93ull, 0xde5c8caeacb24df9ull);
+    const OperConstants opcst_leaftype(0x16f0d31d9311e05dull, 0x9cd949b7ccb8516full, 0xa4aca130e379078dull);
+    const OperConstants opcst_groupIO(0x75b17a0f2e3d1fcaull, 0xb734f30832c956fbull, 0xb252c23e22ea3c25ull);
+    const OperConstants opcst_highhalf(0xdbb083d925b3a584ull, 0x95fbfd4d89ca014dull, 0x814368afa8e14dedull);
+#else
     const OperConstants opcst_and(3390840479u, 659787649u, 165943601u, 913324081u, 153863837u);
     const OperConstants opcst_or(1325711570u, 546652657u, 578143253u, 848168701u, 166296997u);
     const OperConstants opcst_xor(897089714u, 456534161u, 899919529u, 139709989u, 370779613u);
@@ -54,5 +136,7 @@ namespace signatureConstants {
     const OperConstants opcst_slicebounds(70524680u, 444607909u, 848056189u, 509462321u, 700093841u);
     const OperConstants opcst_leaftype(3087564275u, 301977869u, 635134589u, 360062929u, 650573921u);
     const OperConstants opcst_groupIO(2005644964u, 859388701u, 536741141u, 593820389u, 584754689u);
+    const OperConstants opcst_highhalf(1856818124u, 727284373u, 710643841u, 153336341u, 202329989u);
+#endif
 
 }
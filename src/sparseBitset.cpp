@@ -0,0 +1,278 @@
+#include "sparseBitset.h"
+
+#include <algorithm>
+
+using namespace std;
+
+const size_t SparseBitset::CHUNK_BITS;
+const size_t SparseBitset::ARRAY_MAX;
+
+namespace {
+    const size_t WORD_BITS = sizeof(long unsigned) * 8;
+    const size_t CHUNK_WORDS = SparseBitset::CHUNK_BITS / WORD_BITS;
+}
+
+void SparseBitset::SetBitIterator::settle() {
+    while(container < containers->size()) {
+        const Container& chunk = (*containers)[container];
+        size_t base = chunk.key * CHUNK_BITS;
+        if(chunk.isBitmap()) {
+            size_t word = inner / WORD_BITS;
+            if(word < CHUNK_WORDS) {
+                Word bits = chunk.words[word] & (~0lu << (inner % WORD_BITS));
+                while(bits == 0 && ++word < CHUNK_WORDS)
+                    bits = chunk.words[word];
+                if(bits != 0) {
+                    inner = word * WORD_BITS + __builtin_ctzl(bits);
+                    cur = base + inner;
+                    return;
+                }
+            }
+        }
+        else if(inner < chunk.values.size()) {
+            cur = base + chunk.values[inner];
+            return;
+        }
+        ++container;
+        inner = 0;
+    }
+}
+
+SparseBitset::SparseBitset(size_t size) : size_(size)
+{}
+
+bool SparseBitset::operator[](size_t pos) const {
+    size_t key = pos / CHUNK_BITS;
+    size_t container = lowerContainer(key);
+    if(container == containers.size() || containers[container].key != key)
+        return false;
+
+    const Container& chunk = containers[container];
+    size_t low = pos % CHUNK_BITS;
+    if(chunk.isBitmap())
+        return chunk.words[low / WORD_BITS] & (1lu << (low % WORD_BITS));
+    return binary_search(chunk.values.begin(), chunk.values.end(), low);
+}
+
+SparseBitset& SparseBitset::operator&=(const DynBitset& mask) {
+    size_t kept = 0;
+    for(auto& chunk: containers) {
+        size_t base = chunk.key * CHUNK_BITS;
+        if(chunk.isBitmap()) {
+            for(size_t word = 0; word < CHUNK_WORDS; ++word) {
+                Word bits = chunk.words[word];
+                while(bits != 0) {
+                    size_t bit = __builtin_ctzl(bits);
+                    bits &= bits - 1;
+                    if(!mask[base + word * WORD_BITS + bit]) {
+                        chunk.words[word] &= ~(1lu << bit);
+                        --chunk.card;
+                    }
+                }
+            }
+            if(chunk.card <= ARRAY_MAX)
+                toArray(chunk);
+        }
+        else {
+            auto end = remove_if(chunk.values.begin(), chunk.values.end(),
+                    [&](uint16_t low) { return !mask[base + low]; });
+            chunk.values.erase(end, chunk.values.end());
+            chunk.card = chunk.values.size();
+        }
+
+        if(chunk.card > 0) {
+            if(&containers[kept] != &chunk)
+                swap(containers[kept], chunk);
+            ++kept;
+        }
+    }
+    containers.erase(containers.begin() + kept, containers.end());
+    return *this;
+}
+
+bool SparseBitset::intersects(const SparseBitset& oth) const {
+    size_t pos = 0, othPos = 0;
+    while(pos < containers.size() && othPos < oth.containers.size()) {
+        const Container& chunk = containers[pos];
+        const Container& othChunk = oth.containers[othPos];
+        if(chunk.key < othChunk.key) {
+            ++pos;
+            continue;
+        }
+        if(othChunk.key < chunk.key) {
+            ++othPos;
+            continue;
+        }
+
+        if(chunk.isBitmap() && othChunk.isBitmap()) {
+            for(size_t word = 0; word < CHUNK_WORDS; ++word)
+                if(chunk.words[word] & othChunk.words[word])
+                    return true;
+        }
+        else if(chunk.isBitmap() || othChunk.isBitmap()) {
+            const Container& bitmap = chunk.isBitmap() ? chunk : othChunk;
+            const Container& array = chunk.isBitmap() ? othChunk : chunk;
+            for(auto low: array.values)
+                if(bitmap.words[low / WORD_BITS] & (1lu << (low % WORD_BITS)))
+                    return true;
+        }
+        else {
+            // Look the values of the smaller array up in the larger one
+            const Container& small =
+                chunk.card <= othChunk.card ? chunk : othChunk;
+            const Container& large =
+                chunk.card <= othChunk.card ? othChunk : chunk;
+            auto from = large.values.begin();
+            for(auto low: small.values) {
+                from = lower_bound(from, large.values.end(), low);
+                if(from == large.values.end())
+                    break;
+                if(*from == low)
+                    return true;
+            }
+        }
+        ++pos;
+        ++othPos;
+    }
+    return false;
+}
+
+bool SparseBitset::intersects(const DynBitset& oth) const {
+    if(oth.size() != size_)
+        throw DynBitset::SizeMismatch();
+    for(auto bit = setBits_begin(); bit != setBits_end(); ++bit)
+        if(oth[*bit])
+            return true;
+    return false;
+}
+
+size_t SparseBitset::count() const {
+    size_t out = 0;
+    for(const auto& chunk: containers)
+        out += chunk.card;
+    return out;
+}
+
+int SparseBitset::singleBit() const {
+    if(containers.size() != 1 || containers[0].card != 1)
+        return -1;
+    return *setBits_begin();
+}
+
+std::string SparseBitset::dump() const {
+    std::string out;
+    for(auto bit = setBits_begin(); bit != setBits_end(); ++bit) {
+        if(!out.empty())
+            out += ' ';
+        out += to_string(*bit);
+    }
+    return out;
+}
+
+size_t SparseBitset::lowerContainer(size_t key) const {
+    return lower_bound(containers.begin(), containers.end(), key,
+            [](const Container& chunk, size_t key) {
+                return chunk.key < key;
+            }) - containers.begin();
+}
+
+size_t SparseBitset::findFrom(size_t pos) const {
+    if(pos >= size_)
+        return size_;
+
+    SetBitIterator it(&containers, lowerContainer(pos / CHUNK_BITS));
+    if(it.container < containers.size()
+            && containers[it.container].key == pos / CHUNK_BITS)
+    {
+        // Start the iteration at `pos` in its chunk
+        const Container& chunk = containers[it.container];
+        size_t low = pos % CHUNK_BITS;
+        it.inner = chunk.isBitmap() ? low :
+            lower_bound(chunk.values.begin(), chunk.values.end(), low)
+                - chunk.values.begin();
+        it.settle();
+    }
+    return it == setBits_end() ? size_ : *it;
+}
+
+void SparseBitset::setBit(size_t pos) {
+    size_t key = pos / CHUNK_BITS;
+    size_t container = lowerContainer(key);
+    if(container == containers.size() || containers[container].key != key)
+        containers.insert(containers.begin() + container, Container(key));
+
+    Container& chunk = containers[container];
+    size_t low = pos % CHUNK_BITS;
+    if(chunk.isBitmap()) {
+        Word& word = chunk.words[low / WORD_BITS];
+        Word bit = 1lu << (low % WORD_BITS);
+        if(!(word & bit)) {
+            word |= bit;
+            ++chunk.card;
+        }
+        return;
+    }
+
+    auto at = lower_bound(chunk.values.begin(), chunk.values.end(), low);
+    if(at != chunk.values.end() && *at == low)
+        return;
+    chunk.values.insert(at, low);
+    ++chunk.card;
+    if(chunk.card > ARRAY_MAX)
+        toBitmap(chunk);
+}
+
+void SparseBitset::resetBit(size_t pos) {
+    size_t key = pos / CHUNK_BITS;
+    size_t container = lowerContainer(key);
+    if(container == containers.size() || containers[container].key != key)
+        return;
+
+    Container& chunk = containers[container];
+    size_t low = pos % CHUNK_BITS;
+    if(chunk.isBitmap()) {
+        Word& word = chunk.words[low / WORD_BITS];
+        Word bit = 1lu << (low % WORD_BITS);
+        if(!(word & bit))
+            return;
+        word &= ~bit;
+        --chunk.card;
+        if(chunk.card <= ARRAY_MAX)
+            toArray(chunk);
+    }
+    else {
+        auto at = lower_bound(chunk.values.begin(), chunk.values.end(), low);
+        if(at == chunk.values.end() || *at != low)
+            return;
+        chunk.values.erase(at);
+        --chunk.card;
+    }
+
+    if(chunk.card == 0)
+        containers.erase(containers.begin() + container);
+}
+
+void SparseBitset::toBitmap(Container& container) {
+    container.words.assign(CHUNK_WORDS, 0);
+    for(auto low: container.values)
+        container.words[low / WORD_BITS] |= 1lu << (low % WORD_BITS);
+    container.values.clear();
+}
+
+void SparseBitset::toArray(Container& container) {
+    container.values.clear();
+    for(size_t word = 0; word < CHUNK_WORDS; ++word) {
+        Word bits = container.words[word];
+        while(bits != 0) {
+            container.values.push_back(word * WORD_BITS
+                    + __builtin_ctzl(bits));
+            bits &= bits - 1;
+        }
+    }
+    container.words.clear();
+}
+
+void SparseMatrix::andRows(const DynBitset& mask) {
+    for(auto& row: rowSets)
+        row &= mask;
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dyn_bitset.h"
+
+/** Compressed bitset, for sets of bits much sparser than their size.
+ *
+ * The bit positions are split in chunks of `CHUNK_BITS` bits, after the
+ * "roaring bitmaps" layout. Only the chunks holding some set bits are
+ * stored, each in a container fitting its density: an *array* container
+ * holds the sorted low 16 bits of the positions, up to `ARRAY_MAX` of them;
+ * past this, a *bitmap* container holds the chunk as plain words.
+ *
+ * Most operations thus cost in the number of set bits, instead of the size
+ * of the bitset as for `DynBitset`. Its interface mirrors `DynBitset`'s, so
+ * that both can be used interchangeably by templated code (see
+ * `subcircMatch.cpp`).
+ */
+class SparseBitset {
+    private:
+        typedef long unsigned Word;
+
+        struct Container {
+            Container(size_t key) : key(key), card(0) {}
+
+            /// Checks whether this is a bitmap container
+            bool isBitmap() const { return !words.empty(); }
+
+            size_t key; ///< Position of the chunk
+            size_t card; ///< Number of set bits in the chunk
+            std::vector<uint16_t> values; ///< Sorted, for array containers
+            std::vector<Word> words; ///< For bitmap containers
+        };
+
+    public:
+        /// Bits per chunk, that is, per container
+        static const size_t CHUNK_BITS = 1 << 16;
+
+        /// Maximal number of bits set in an array container
+        static const size_t ARRAY_MAX = 4096;
+
+        class Reference {
+            friend class SparseBitset;
+            public:
+                /// Sets the bit to a given value
+                Reference& operator=(bool val) {
+                    if(val)
+                        set();
+                    else
+                        reset();
+                    return *this;
+                }
+
+                /// Value of the reference
+                operator bool() const {
+                    return static_cast<const SparseBitset&>(*bitset)[pos];
+                }
+
+                /// Sets the bit
+                void set() { bitset->setBit(pos); }
+
+                /// Resets the bit
+                void reset() { bitset->resetBit(pos); }
+
+            private:
+                Reference(SparseBitset* bitset, size_t pos)
+                    : bitset(bitset), pos(pos) {}
+
+                SparseBitset* bitset;
+                size_t pos;
+        };
+
+        /** Iterator over the positions of the set bits, in increasing order.
+         * It is invalidated by any alteration of the bitset. */
+        class SetBitIterator {
+            friend class SparseBitset;
+            public:
+                /// Position of the current set bit
+                size_t operator*() const { return cur; }
+
+                /// Moves to the next set bit
+                SetBitIterator& operator++() {
+                    ++inner;
+                    settle();
+                    return *this;
+                }
+
+                bool operator==(const SetBitIterator& oth) const {
+                    return container == oth.container && inner == oth.inner;
+                }
+                bool operator!=(const SetBitIterator& oth) const {
+                    return !operator==(oth);
+                }
+
+            private:
+                SetBitIterator(const std::vector<Container>* containers,
+                        size_t container)
+                    : containers(containers), container(container), inner(0),
+                    cur(0)
+                {
+                    settle();
+                }
+
+                /** Moves to the first set bit at or after the current
+                 * position, if the current one is not set */
+                void settle();
+
+                const std::vector<Container>* containers;
+                size_t container;
+                size_t inner; ///< Array index or bit position in the chunk
+                size_t cur; ///< Current set bit
+        };
+
+        /// `size` is expressed in bits. Initializes to zeroes.
+        SparseBitset(size_t size);
+
+        size_t size() const { return size_; }
+
+        /// Constant bit access operator
+        bool operator[](size_t pos) const;
+
+        /// Alterable bit reference
+        Reference operator[](size_t pos) { return Reference(this, pos); }
+
+        /// In-place bitwise and with a dense `mask`
+        SparseBitset& operator&=(const DynBitset& mask);
+
+        /// Sets all bits to false
+        void reset() { containers.clear(); }
+
+        /// Checks if any bit is true
+        bool any() const { return !containers.empty(); }
+
+        /// Checks if any bit above the `pos`th (incl.) is true
+        bool anyOver(size_t pos) const { return findFrom(pos) < size_; }
+
+        /** Checks whether `*this & oth` has any bit set, without building
+         * it */
+        bool intersects(const SparseBitset& oth) const;
+
+        /// Same as above, with a dense bitset of the same size
+        bool intersects(const DynBitset& oth) const;
+
+        /// Number of set bits
+        size_t count() const;
+
+        /// Position of the first set bit, or `size()` if there is none
+        size_t findFirst() const { return findFrom(0); }
+
+        /** Position of the first set bit after the `pos`th (excl.), or
+         * `size()` if there is none */
+        size_t findNext(size_t pos) const { return findFrom(pos + 1); }
+
+        /// Iterator to the first set bit
+        SetBitIterator setBits_begin() const {
+            return SetBitIterator(&containers, 0);
+        }
+
+        /// Past-the-end of `setBits_begin`
+        SetBitIterator setBits_end() const {
+            return SetBitIterator(&containers, containers.size());
+        }
+
+        /** Checks whether a single bit is set. If so, returns this bit's
+         * position; if no or multiple bits are set, returns -1. */
+        int singleBit() const;
+
+        /// Dumps the positions of the set bits
+        std::string dump() const;
+
+    private:
+        /// Position of the first container whose key is at least `key`
+        size_t lowerContainer(size_t key) const;
+
+        /** Position of the first set bit after the `pos`th (incl.), or
+         * `size()` if there is none */
+        size_t findFrom(size_t pos) const;
+
+        void setBit(size_t pos);
+        void resetBit(size_t pos);
+
+        /// Turns an array container into a bitmap container, and back
+        static void toBitmap(Container& container);
+        static void toArray(Container& container);
+
+        size_t size_;
+        std::vector<Container> containers; ///< By increasing key
+};
+
+/** Matrix of bits whose rows are `SparseBitset`s, mirroring `BitMatrix`.
+ *
+ * Copying a matrix onto another one of the same dimensions reuses the
+ * latter's storage as much as possible.
+ */
+class SparseMatrix {
+    public:
+        /// All the bits are initialized to zero
+        SparseMatrix(size_t rows, size_t cols)
+            : rowSets(rows, SparseBitset(cols)), cols_(cols)
+        {}
+
+        /// Number of rows
+        size_t rows() const { return rowSets.size(); }
+
+        /// Number of columns, that is, the size of each row
+        size_t cols() const { return cols_; }
+
+        /// The `row`-th row
+        SparseBitset& operator[](size_t row) { return rowSets[row]; }
+
+        /// Constant version of `operator[]`
+        const SparseBitset& operator[](size_t row) const {
+            return rowSets[row];
+        }
+
+        /// In-place bitwise and of every row with `mask`
+        void andRows(const DynBitset& mask);
+
+    private:
+        std::vector<SparseBitset> rowSets;
+        size_t cols_;
+};
@@ -1,16 +1,17 @@
 #include "subcircMatch.h"
-#include <map>
-#include <set>
-#include <unordered_map>
 #include <vector>
 #include <list>
 #include <stdexcept>
 #include <algorithm>
 
 #include "circuitGroup.h"
+#include "conflictGraph.h"
 #include "dyn_bitset.h"
+#include "searchBudget.h"
+#include "sparseBitset.h"
 #include "logging.h"
 #include "debug.h"
+#include "sigStats.h"
 
 using namespace std;
 
@@ -23,8 +24,32 @@ class ImplementationBug: public std::runtime_error {
 
 namespace {
 
-typedef std::vector<DynBitset> PermMatrix;
-typedef std::vector<DynBitset> AdjacencyMatr;
+MatchMatrices matchMatrices = MatchMatrices::AUTO;
+
+/** Number of haystack vertices from which `MatchMatrices::AUTO` picks the
+ * sparse representation */
+const size_t SPARSE_THRESHOLD = 4096;
+
+bool useSparseMatrices(size_t hayVertices) {
+    if(matchMatrices == MatchMatrices::AUTO)
+        return hayVertices >= SPARSE_THRESHOLD;
+    return matchMatrices == MatchMatrices::SPARSE;
+}
+
+MatchStrategy matchStrategy = MatchStrategy::AUTO;
+
+/** Number of haystack vertices from which `MatchStrategy::AUTO` searches
+ * around anchors */
+const size_t ANCHORED_THRESHOLD = 64;
+
+bool useAnchors(size_t hayVertices) {
+    if(matchStrategy == MatchStrategy::AUTO)
+        return hayVertices >= ANCHORED_THRESHOLD;
+    return matchStrategy == MatchStrategy::ANCHORED;
+}
+
+MatchSelection matchSelection = MatchSelection::GREEDY;
+chrono::milliseconds selectionBudget(100);
 
 struct Vertice {
     Vertice(WireId* w) : type(VertWire), wire(w) {}
@@ -39,19 +64,75 @@ struct Vertice {
     };
 };
 
+/// Vertice id of the wires and children left out of a `VerticeMapping`
+const size_t UNMAPPED = (size_t)-1;
+
+/** Vertice ids of the wires and children of a group, or of a part of them
+ * only (see `mapVertices`) */
 struct VerticeMapping {
-    unordered_map<WireId*, size_t> wireId;
-    map<CircuitTree*, size_t> circId;
+    const CircuitGroup* group;
+    const WireManager* manager;
+    size_t circBase; ///< Vertice id of the first mapped child
+    vector<size_t> wireIds; ///< By `WireManager::uniqueIndex`
+    vector<size_t> circIds; ///< By `CircuitTree::childIndex`
     vector<Vertice> vertices;
+
+    /// Vertice id of `wire`, a wire of the group, or `UNMAPPED`
+    size_t wireId(const WireId* wire) const {
+        return wireIds[manager->uniqueIndex(wire)];
+    }
+
+    /// Vertice id of `circ`, a child of the group, or `UNMAPPED`
+    size_t circId(const CircuitTree* circ) const {
+        return circIds[circ->childIndex()];
+    }
 };
 
+/** Candidate haystack children of each needle child, as sorted
+ * `CircuitTree::childIndex`es, indexed by the needle child's */
+typedef vector<vector<size_t> > Candidates;
+
 struct FullMapping {
     VerticeMapping haystack, needle;
 };
 
-/// Recursively finds `needle` in `haystack` filling `results`
+/** `MatchBindings` resolved on a needle and a haystack group, see
+ * `resolveBindings`. Both vectors are empty when nothing is bound. */
+struct Bindings {
+    const WireManager* needleManager;
+    /// Haystack wire bound to each needle wire, by `uniqueIndex`, or nullptr
+    vector<WireId*> wires;
+    /// Haystack child bound to each needle child, by `childIndex`, or nullptr
+    vector<CircuitTree*> parts;
+
+    /// Haystack wire bound to the needle wire `wire`, or nullptr
+    WireId* wireOf(const WireId* wire) const {
+        if(wires.empty())
+            return nullptr;
+        return wires[needleManager->uniqueIndex(wire)];
+    }
+
+    /// Haystack child bound to the needle child `part`, or nullptr
+    CircuitTree* partOf(const CircuitTree* part) const {
+        if(parts.empty())
+            return nullptr;
+        return parts[part->childIndex()];
+    }
+};
+
+/** Recursively finds `needle` in `haystack`, which is `depth` levels below
+ * the root of `scope`, filling `results` */
 void findIn(vector<MatchResult>& results,
-        CircuitGroup* needle, CircuitGroup* haystack);
+        const CircuitGroup* needle, const CircuitGroup* haystack,
+        const MatchScope& scope, int depth);
+
+/** Finds `needle` among the children of `haystack` only, filling `results`.
+ * The children marked in `alreadyImplied` are left out; the matches must
+ * conform to `bindings`. */
+void findLocal(vector<MatchResult>& results,
+        const CircuitGroup* needle, const CircuitGroup* haystack,
+        DynBitset& alreadyImplied,
+        const Bindings& bindings);
 
 // ========================================================================
 
@@ -59,57 +140,42 @@ sign_t localSign(CircuitTree* circ) {
     return circ->sign(0);
 }
 
-class WireFit {
+/** Fitness of the haystack's wires for the roles of the needle's wires, that
+ * is, whether a haystack wire has (at least) the connections a needle wire
+ * has, to circuits of the same signatures, on the same pins.
+ *
+ * The connections of each wire are kept as a sorted vector, and the
+ * fitnesses are cached in a dense haystack x needle table; wires are indexed
+ * by their `WireManager::uniqueIndex`.
+ */
+class WireFitTable {
     public:
-        /** Add a connection on this wire from a circuit of signature
-         * `inSig`, from its `pin`-th pin, which is an input of the circuit
-         * iff `in` is true. */
-        void connected(sign_t inSig, bool in, int pin) {
-            ++conns[ConnType(inSig, in, pin)];
-        }
-
-        /** Check whether this wire has the required connections to act as
-         * `role` */
-        bool fitFor(WireId* role) {
-            try {
-                return fitness.at(role);
-            } catch(const std::out_of_range&) {
-                map<ConnType, int> usedConns;
-
-                for(auto circ = role->adjacent_begin();
-                        circ != role->adjacent_end(); ++circ)
-                {
-                    bool isInput = true;
-                    int pinPos = 0;
-                    for(auto circWire = (*circ)->io_begin();
-                            circWire != (*circ)->io_end();
-                            ++circWire, ++pinPos)
-                    {
-                        if(circWire == (*circ)->inp_end()) {
-                            pinPos = 0;
-                            isInput = false;
-                        }
-                        if(**circWire == *role)
-                            break;
-                    }
-                    ConnType cConn(localSign(*circ), isInput, pinPos);
-
-                    ++usedConns[cConn];
-                    if(usedConns[cConn] > conns[cConn]) {
-                        fitness[role] = false;
-                        return false;
-                    }
-                }
-                fitness[role] = true;
-                return true;
-            }
-        }
+        /** Collects the connections of the `needle`'s wires, and of the
+         * `haystack`'s wires to the candidate circuits of `singleMatches` */
+        WireFitTable(const CircuitGroup* needle, const CircuitGroup* haystack,
+                const Candidates& singleMatches);
+
+        /** Check whether the haystack wire `wire` has the required
+         * connections to act as the needle wire `role` */
+        bool fitFor(WireId* wire, WireId* role);
+
+        /** Calls `fit(wire, role)` for every haystack wire `wire` having
+         * the connections and the degree required to act as the needle
+         * wire `role`. The haystack wires are bucketed by connections and
+         * degree, so that each bucket is checked once per role. */
+        template<typename Fn>
+        void forEachFit(Fn fit) const;
+
+        /** Same as above, for the wires mapped in `hay` only, without
+         * bucketing: cheaper on a small part of the haystack */
+        template<typename Fn>
+        void forEachFit(const VerticeMapping& hay, Fn fit);
 
     private:
         struct ConnType {
             ConnType(sign_t inSig, bool in, int pin) :
                 inSig(inSig), in(in), pin(pin) {}
-            bool operator==(const ConnType& e) {
+            bool operator==(const ConnType& e) const {
                 return inSig == e.inSig && in == e.in && pin == e.pin;
             }
             bool operator<(const ConnType& e) const {
@@ -124,35 +190,194 @@ class WireFit {
             int pin;
         };
 
-        map<ConnType, int> conns;
-        unordered_map<WireId*, bool> fitness;
+        /// Connections of a wire, sorted, with repetitions
+        typedef vector<ConnType> Profile;
+
+        /// Haystack wires sharing the same connections and degree
+        struct Bucket {
+            size_t circs, pins; ///< Degree, see `WireId::connectedCirc`
+            const Profile* profile;
+            vector<size_t> wires;
+        };
+
+        /// Adds the connections of `circ`, of signature `sig`, to `profiles`
+        static void addConnections(CircuitTree* circ, sign_t sig,
+                const WireManager* manager, vector<Profile>& profiles);
+
+        /// Checks whether `hay` has every connection of `role`
+        static bool hosts(const Profile& hay, const Profile& role) {
+            return includes(hay.begin(), hay.end(),
+                    role.begin(), role.end());
+        }
+
+        const WireManager* hayManager;
+        const WireManager* needleManager;
+        vector<Profile> hayProfiles, roleProfiles;
+        vector<Bucket> buckets;
+
+        enum Fitness : char { UNKNOWN, FIT, UNFIT };
+        vector<Fitness> fitness; ///< Haystack-major
 };
 
+WireFitTable::WireFitTable(const CircuitGroup* needle, const CircuitGroup* haystack,
+        const Candidates& singleMatches)
+    : hayManager(haystack->wireManager()),
+    needleManager(needle->wireManager()),
+    hayProfiles(hayManager->wires().size()),
+    roleProfiles(needleManager->wires().size()),
+    fitness(hayProfiles.size() * roleProfiles.size(), UNKNOWN)
+{
+    for(auto circ: needle->getChildrenCst())
+        addConnections(circ, localSign(circ), needleManager, roleProfiles);
+
+    // Needle circuits of the same signature share their candidates
+    const vector<CircuitTree*>& hayChildren = haystack->getChildrenCst();
+    DynBitset seen(hayChildren.size());
+    for(const auto& matches: singleMatches) {
+        for(auto match: matches) {
+            if(seen[match])
+                continue;
+            seen[match].set();
+            addConnections(hayChildren[match], localSign(hayChildren[match]),
+                    hayManager, hayProfiles);
+        }
+    }
+
+    for(auto& profile: hayProfiles)
+        sort(profile.begin(), profile.end());
+    for(auto& profile: roleProfiles)
+        sort(profile.begin(), profile.end());
+
+    // Bucket the haystack wires
+    const vector<WireId*>& hayWires = hayManager->wires();
+    vector<size_t> order(hayWires.size());
+    vector<pair<size_t, size_t> > degrees(hayWires.size());
+    for(size_t wire = 0; wire < hayWires.size(); ++wire) {
+        order[wire] = wire;
+        degrees[wire] = make_pair(hayWires[wire]->connectedCirc().size(),
+                hayWires[wire]->connectedPins().size());
+    }
+    auto lessThan = [&](size_t fst, size_t snd) {
+        if(degrees[fst] != degrees[snd])
+            return degrees[fst] < degrees[snd];
+        return hayProfiles[fst] < hayProfiles[snd];
+    };
+    sort(order.begin(), order.end(), lessThan);
+    for(size_t pos = 0; pos < order.size(); ++pos) {
+        size_t wire = order[pos];
+        if(pos == 0 || lessThan(order[pos - 1], wire)) {
+            Bucket bucket;
+            bucket.circs = degrees[wire].first;
+            bucket.pins = degrees[wire].second;
+            bucket.profile = &hayProfiles[wire];
+            buckets.push_back(bucket);
+        }
+        buckets.back().wires.push_back(wire);
+    }
+}
+
+bool WireFitTable::fitFor(WireId* wire, WireId* role) {
+    size_t hayPos = hayManager->uniqueIndex(wire),
+           rolePos = needleManager->uniqueIndex(role);
+    Fitness& cached = fitness[hayPos * roleProfiles.size() + rolePos];
+    if(cached == UNKNOWN)
+        cached = hosts(hayProfiles[hayPos], roleProfiles[rolePos]) ?
+            FIT : UNFIT;
+    return cached == FIT;
+}
+
+template<typename Fn>
+void WireFitTable::forEachFit(Fn fit) const {
+    const vector<WireId*>& hayWires = hayManager->wires();
+    const vector<WireId*>& roles = needleManager->wires();
+    for(size_t rolePos = 0; rolePos < roles.size(); ++rolePos) {
+        WireId* role = roles[rolePos];
+        size_t circs = role->connectedCirc().size(),
+               pins = role->connectedPins().size();
+        for(const auto& bucket: buckets) {
+            if(bucket.circs < circs || bucket.pins < pins
+                    || !hosts(*bucket.profile, roleProfiles[rolePos]))
+                continue;
+            for(auto wire: bucket.wires)
+                fit(hayWires[wire], role);
+        }
+    }
+}
+
+template<typename Fn>
+void WireFitTable::forEachFit(const VerticeMapping& hay, Fn fit) {
+    const vector<WireId*>& roles = needleManager->wires();
+    for(const auto& vert: hay.vertices) {
+        if(vert.type != Vertice::VertWire)
+            break; // The wires are mapped first
+        WireId* wire = vert.wire;
+        size_t circs = wire->connectedCirc().size(),
+               pins = wire->connectedPins().size();
+        for(auto role: roles) {
+            if(circs >= role->connectedCirc().size()
+                    && pins >= role->connectedPins().size()
+                    && fitFor(wire, role))
+                fit(wire, role);
+        }
+    }
+}
+
+void WireFitTable::addConnections(CircuitTree* circ, sign_t sig,
+        const WireManager* manager, vector<Profile>& profiles)
+{
+    WireSpan inputs = circ->inp_wires(),
+             outputs = circ->out_wires();
+    for(size_t pin = 0; pin < inputs.size(); ++pin) {
+        profiles[manager->uniqueIndex(inputs[pin])].push_back(
+                ConnType(sig, true, pin));
+    }
+    for(size_t pin = 0; pin < outputs.size(); ++pin) {
+        profiles[manager->uniqueIndex(outputs[pin])].push_back(
+                ConnType(sig, false, pin));
+    }
+}
+
 bool isMatchFit(CircuitTree* match, CircuitTree* needleMatch,
-        unordered_map<WireId*, WireFit>& wireFit)
+        WireFitTable& wireFit)
 {
     FIND_DEBUG(" > Checking fitness\n");
-    auto wire = match->io_begin(),
-    role = needleMatch->io_begin();
+    WireSpan wires = match->io_wires(),
+             roles = needleMatch->io_wires();
+    if(wires.size() != roles.size())
+        return false;
 
-    for(; wire != match->io_end()
-            && role != needleMatch->io_end();
-            ++wire, ++role)
-    {
-        if(!wireFit[*wire].fitFor(*role)) {
+    for(size_t pos = 0; pos < wires.size(); ++pos) {
+        if(!wireFit.fitFor(wires[pos], roles[pos])) {
             FIND_DEBUG("  Not fit\n");
             return false;
         }
     }
-    if(wire != match->io_end()
-            || role != needleMatch->io_end())
-    {
+
+    return true;
+}
+
+/** Check whether the haystack child `match` may act as the needle child
+ * `needleMatch` under `bindings`: it must be the bound child if any, and be
+ * connected to the bound wires on the same pins */
+bool conformsTo(CircuitTree* match, CircuitTree* needleMatch,
+        const Bindings& bindings)
+{
+    CircuitTree* boundPart = bindings.partOf(needleMatch);
+    if(boundPart != nullptr && boundPart != match)
         return false;
-    }
 
+    WireSpan wires = match->io_wires(),
+             roles = needleMatch->io_wires();
+    for(size_t pos = 0; pos < roles.size(); ++pos) {
+        WireId* bound = bindings.wireOf(roles[pos]);
+        if(bound != nullptr
+                && (pos >= wires.size() || !(*wires[pos] == *bound)))
+            return false;
+    }
     return true;
 }
 
+template<class PermMatrix>
 void dumpPerm(const PermMatrix& permMatrix, const FullMapping& mapping) {
 #ifndef DEBUG_FIND // UNUSED
     (void)(permMatrix);
@@ -184,6 +409,7 @@ void dumpPerm(const PermMatrix& permMatrix, const FullMapping& mapping) {
 }
 
 /// Check whether a supposed match is actually a match or not.
+template<class PermMatrix>
 bool isActualMatch(const PermMatrix& perm, const FullMapping& mapping)
 {
     /* Here, we must check that the nodes are actually equal to each other.
@@ -192,6 +418,10 @@ bool isActualMatch(const PermMatrix& perm, const FullMapping& mapping)
      */
 
     FIND_DEBUG(" > Checking a potential solution…\n");
+    SIG_STAT_INC(matchChecks);
+
+    const LeafStore& needleStore = mapping.needle.group->leafStore();
+    const LeafStore& haystackStore = mapping.haystack.group->leafStore();
 
     for(size_t needlePos = 0;
             needlePos < mapping.needle.vertices.size();
@@ -219,12 +449,14 @@ bool isActualMatch(const PermMatrix& perm, const FullMapping& mapping)
 #endif
         }
 
-        CircuitTree* needlePart = mapping.needle.vertices[needlePos].circ;
-        CircuitTree* haystackPart = mapping.haystack.vertices[mappedId].circ;
-
-        if(!needlePart->equals(haystackPart)) {
+        size_t needlePart =
+            mapping.needle.vertices[needlePos].circ->childIndex();
+        size_t hayPart = mapping.haystack.vertices[mappedId].circ->childIndex();
+        if(!needleStore.equals(needlePart, haystackStore, hayPart))
+        {
             // MAYBE TODO: propagate down that it is not a match?
             FIND_DEBUG("  > Not sub-equal\n");
+            SIG_STAT_INC(matchCollisions);
             return false;
         }
     }
@@ -234,48 +466,86 @@ bool isActualMatch(const PermMatrix& perm, const FullMapping& mapping)
     return true;
 }
 
-void mapVertices(CircuitGroup* group, VerticeMapping& mapping) {
+/** Maps `wires` and `children`, some wires and children of `group`, to
+ * vertice ids: the wires first, by decreasing degree, then the children in
+ * order. The other wires and children are left `UNMAPPED`. `mapping` must be
+ * fresh, or cleared by `unmapVertices`. */
+void mapVertices(const CircuitGroup* group, vector<WireId*> wires,
+        const vector<CircuitTree*>& children,
+        VerticeMapping& mapping)
+{
     // MAYBE TODO: So far, a bit dumb. Surely we can do better?
-    vector<WireId*> wires = group->wireManager()->wires();
     sort(wires.begin(), wires.end(),
             [](WireId*& e1, WireId*& e2) {
                 return e1->connectedCount() > e2->connectedCount();
             });
 
+    mapping.group = group;
+    mapping.manager = group->wireManager();
+    mapping.wireIds.resize(mapping.manager->wires().size(), UNMAPPED);
+    mapping.circIds.resize(group->getChildrenCst().size(), UNMAPPED);
     for(const auto& wire: wires) {
-        mapping.wireId[wire] = mapping.vertices.size();
+        mapping.wireIds[mapping.manager->uniqueIndex(wire)] =
+            mapping.vertices.size();
         mapping.vertices.push_back(Vertice(wire));
     }
 
-    for(const auto& child: group->getChildrenCst()) {
-        mapping.circId[child] = mapping.vertices.size();
+    mapping.circBase = mapping.vertices.size();
+    for(const auto& child: children) {
+        mapping.circIds[child->childIndex()] = mapping.vertices.size();
         mapping.vertices.push_back(Vertice(child));
     }
 }
 
-/// Sets bits in the adjacency matrix when circuits are adjacent
-void buildAdjacency(CircuitGroup* group,
-        const VerticeMapping& mapping,
-        AdjacencyMatr& adjacency)
+/// Maps every wire and child of `group`, see above
+void mapVertices(const CircuitGroup* group, VerticeMapping& mapping) {
+    mapVertices(group, group->wireManager()->wires(),
+            group->getChildrenCst(), mapping);
+}
+
+/** Clears `mapping`, in time linear in its number of vertices, so that it
+ * can be reused on the same group */
+void unmapVertices(VerticeMapping& mapping) {
+    for(const auto& vert: mapping.vertices) {
+        if(vert.type == Vertice::VertWire)
+            mapping.wireIds[mapping.manager->uniqueIndex(vert.wire)] =
+                UNMAPPED;
+        else
+            mapping.circIds[vert.circ->childIndex()] = UNMAPPED;
+    }
+    mapping.vertices.clear();
+}
+
+/** Sets bits in the adjacency matrix when circuits are adjacent, among the
+ * vertices of `mapping` */
+template<class AdjacencyMatr>
+void buildAdjacency(const VerticeMapping& mapping, AdjacencyMatr& adjacency)
 {
-    for(const auto& wire: group->wireManager()->wires()) {
-        size_t wireId = mapping.wireId.at(wire);
+    for(size_t wireId = 0; wireId < mapping.circBase; ++wireId) {
+        WireId* wire = mapping.vertices[wireId].wire;
         for(auto circ = wire->adjacent_begin();
                 circ != wire->adjacent_end();
                 ++circ)
         {
-            size_t circId = mapping.circId.at(*circ);
+            size_t circId = mapping.circId(*circ);
+            if(circId == UNMAPPED)
+                continue;
             adjacency[circId][wireId].set();
             adjacency[wireId][circId].set();
         }
     }
 }
 
+/** Haystack wire mapped to the needle wire `of`, or `nullptr` if `of` is left
+ * out of the mapping */
+template<class PermMatrix>
 WireId* mappedWire(WireId* of,
         const FullMapping& mapping,
         const PermMatrix& perm)
 {
-    size_t needleId = mapping.needle.wireId.at(of);
+    size_t needleId = mapping.needle.wireId(of);
+    if(needleId == UNMAPPED)
+        return nullptr; // See `findAround`
     int matchId = perm[needleId].singleBit();
 #ifdef DEBUG_FIND
     if(matchId < 0)
@@ -288,6 +558,7 @@ WireId* mappedWire(WireId* of,
 }
 
 /// Create a `MatchResult` based on match maps
+template<class PermMatrix>
 MatchResult buildMatchResult(
         const CircuitGroup* fullNeedle,
         const FullMapping& mapping,
@@ -296,7 +567,7 @@ MatchResult buildMatchResult(
 {
     MatchResult res;
     for(const auto& needlePart: fullNeedle->getChildrenCst()) {
-        size_t needleId = mapping.needle.circId.at(needlePart);
+        size_t needleId = mapping.needle.circId(needlePart);
         int matchId = perm[needleId].singleBit();
 #ifdef DEBUG_FIND
         if(matchId < 0)
@@ -315,36 +586,37 @@ MatchResult buildMatchResult(
     return res;
 }
 
+template<class PermMatrix, class AdjacencyMatr>
 bool ullmannRefine(PermMatrix& matr,
         const FullMapping& mapping,
         const AdjacencyMatr& hayAdj)
 {
     bool changed = true;
     size_t nbNeedle = mapping.needle.vertices.size();
+    vector<size_t> unfit; // Candidates of the current row to be dropped
     while(changed) {
         changed = false;
         for(size_t needleId = 0; needleId < nbNeedle; ++needleId) {
             if(!matr[needleId].any())
                 return false;
 
+            // The unfit candidates are only dropped once the row is scanned,
+            // which does not change the outcome (no vertex is its own
+            // neighbour), but keeps the iteration valid.
+            unfit.clear();
             const Vertice& needleVert = mapping.needle.vertices[needleId];
-            for(size_t hayId = 0; hayId < mapping.haystack.vertices.size();
-                    ++hayId)
+            auto hayEnd = matr[needleId].setBits_end();
+            for(auto hayIt = matr[needleId].setBits_begin();
+                    hayIt != hayEnd; ++hayIt)
             {
-                if(!matr[needleId][hayId])
-                    continue;
-
+                size_t hayId = *hayIt;
                 if(needleVert.type == Vertice::VertCirc) {
                     const CircuitTree* needle = needleVert.circ;
-                    for(auto needleNeigh = needle->io_begin();
-                            needleNeigh != needle->io_end();
-                            ++needleNeigh)
-                    {
+                    for(auto needleNeigh: needle->io_wires()) {
                         size_t neighId =
-                            mapping.needle.wireId.at(*needleNeigh);
-                        if(!(matr[neighId] & hayAdj[hayId]).any()) {
-                            changed = true;
-                            matr[needleId][hayId].reset();
+                            mapping.needle.wireId(needleNeigh);
+                        if(!hayAdj[hayId].intersects(matr[neighId])) {
+                            unfit.push_back(hayId);
                             break;
                         }
                     }
@@ -356,21 +628,26 @@ bool ullmannRefine(PermMatrix& matr,
                             ++needleNeigh)
                     {
                         size_t neighId =
-                            mapping.needle.circId.at(*needleNeigh);
-                        if(!(matr[neighId] & hayAdj[hayId]).any()) {
-                            changed = true;
-                            matr[needleId][hayId].reset();
+                            mapping.needle.circId(*needleNeigh);
+                        if(!hayAdj[hayId].intersects(matr[neighId])) {
+                            unfit.push_back(hayId);
                             break;
                         }
                     }
                 }
             }
+
+            for(auto hayId: unfit)
+                matr[needleId][hayId].reset();
+            if(!unfit.empty())
+                changed = true;
         }
     }
 
     return true;
 }
 
+template<class PermMatrix, class AdjacencyMatr>
 void ullmannFindDepth(size_t depth,
         DynBitset& freeHayVert,
         vector<MatchResult>& results,
@@ -378,178 +655,620 @@ void ullmannFindDepth(size_t depth,
         DynBitset& toUnmapHaystack,
         const FullMapping& mapping,
         const AdjacencyMatr& hayAdj,
-        const CircuitGroup* fullNeedle)
+        const CircuitGroup* fullNeedle,
+        bool overlapping)
 {
     FIND_DEBUG("> Ullmann: depth %lu/%lu\n", depth,
             mapping.needle.vertices.size());
-    if(! (matr[depth] & freeHayVert).any())
+    if(!matr[depth].intersects(freeHayVert))
         return;
 
     PermMatrix matrDump = matr; // Copies stuff
+    DynBitset toUnmapCur(mapping.haystack.vertices.size());
 
-    for(size_t hayId = 0; hayId < mapping.haystack.vertices.size(); ++hayId) {
-        if(!matr[depth][hayId] || !freeHayVert[hayId])
+    // `matr` is restored to `matrDump` after each candidate, whose row may
+    // lose bits on the way: look for the next candidate in there.
+    for(size_t hayId = matrDump[depth].findFirst();
+            hayId < mapping.haystack.vertices.size();
+            hayId = matrDump[depth].findNext(hayId))
+    {
+        if(!freeHayVert[hayId])
             continue;
+        if(!SearchBudget::spend())
+            break;
 
         matr[depth].reset();
         matr[depth][hayId].set();
 
-        DynBitset toUnmapCur(mapping.haystack.vertices.size());
         if(ullmannRefine(matr, mapping, hayAdj)) {
             if(depth == mapping.needle.vertices.size() - 1) {
                 if(isActualMatch(matr, mapping)) {
                     results.push_back(buildMatchResult(
                                 fullNeedle, mapping, matr, toUnmapCur));
+                    if(overlapping) // Keep its circuits available
+                        toUnmapCur.reset();
                 }
             }
             else {
                 freeHayVert[hayId].reset();
                 FIND_DEBUG(">> Picking %lu at %lu\n", hayId, depth);
                 ullmannFindDepth(depth + 1, freeHayVert, results, matr,
-                        toUnmapCur, mapping, hayAdj, fullNeedle);
+                        toUnmapCur, mapping, hayAdj, fullNeedle, overlapping);
                 freeHayVert[hayId].set();
             }
         }
 
-        toUnmapHaystack |= toUnmapCur;
+        // `toUnmapCur` is most often empty: skip the full-width operations
+        bool unmapped = toUnmapCur.any();
+        if(unmapped)
+            toUnmapHaystack |= toUnmapCur;
 
         if(!matrDump[depth].anyOver(hayId+1))
             break;
 
-        if(toUnmapCur.any()) {
-            for(auto& row: matrDump)
-                row &= ~toUnmapCur;
+        if(unmapped) {
+            matrDump.andRows(~toUnmapCur);
+            toUnmapCur.reset();
         }
         matr = matrDump;
     }
 }
 
+template<class PermMatrix, class AdjacencyMatr>
 void ullmannFind(vector<MatchResult>& results,
         PermMatrix& matr,
         const FullMapping& mapping,
         const AdjacencyMatr& hayAdj,
         const CircuitGroup* fullNeedle,
-        const set<CircuitTree*> alreadyImplied)
+        const DynBitset& alreadyImplied,
+        bool overlapping)
 {
     DynBitset freeHayVert(mapping.haystack.vertices.size());
     freeHayVert.flip(); // Everything's free to begin with
-    for(const auto& circ: alreadyImplied)
-        freeHayVert[mapping.haystack.circId.at(circ)].reset();
+    const vector<Vertice>& hayVertices = mapping.haystack.vertices;
+    for(size_t hayId = mapping.haystack.circBase;
+            hayId < hayVertices.size(); ++hayId)
+    {
+        if(alreadyImplied[hayVertices[hayId].circ->childIndex()])
+            freeHayVert[hayId].reset();
+    }
     DynBitset toUnmap(mapping.haystack.vertices.size());
     ullmannFindDepth(0, freeHayVert, results, matr, toUnmap, mapping, hayAdj,
-            fullNeedle);
+            fullNeedle, overlapping);
 }
 
-void findIn(vector<MatchResult>& results,
-        CircuitGroup* needle, CircuitGroup* haystack)
+/** Runs Ullmann's algorithm on the mapped `needle` and haystack, with the
+ * given representations of the permutation and adjacency matrices. The
+ * haystack may be mapped only partly (see `findAround`), in which case the
+ * `singleMatches` must be mapped. */
+template<class PermMatrix, class AdjacencyMatr>
+void ullmannMatch(vector<MatchResult>& results,
+        const CircuitGroup* needle,
+        const FullMapping& mapping,
+        const Candidates& singleMatches,
+        WireFitTable& wireFit,
+        const DynBitset& alreadyImplied,
+        const Bindings& bindings,
+        bool overlapping)
 {
-    // Circuits that are already part of a match result
-    set<CircuitTree*> alreadyImplied;
+    const VerticeMapping& hayMapping = mapping.haystack;
 
-    // Recurse in hierarchy
-    for(auto& child: haystack->getChildrenCst()) {
-        if(child->circType() == CircuitTree::CIRC_GROUP) {
-            size_t prevMatches = results.size();
-            findIn(results, needle, dynamic_cast<CircuitGroup*>(child));
-            if(results.size() != prevMatches)
-                alreadyImplied.insert(child);
-        }
+    // Determine haystack's adjacencies
+    AdjacencyMatr hayAdj(hayMapping.vertices.size(),
+            hayMapping.vertices.size());
+    buildAdjacency(hayMapping, hayAdj);
+
+    // == Ullman's algorithm ==
+    // Build the permutation matrix (initially not a permutation
+    // The matix is |needle| x |haystack|, and a 1 indicates that we think two
+    // vertices could be matches at a given point.
+    PermMatrix permMatrix(
+            mapping.needle.vertices.size(),
+            hayMapping.vertices.size());
+
+    // Setting the possible adjacent circuits (singleMatches)
+    for(size_t needlePart = 0; needlePart < singleMatches.size();
+            ++needlePart)
+    {
+        size_t needleId = mapping.needle.circBase + needlePart;
+        for(auto hayPart: singleMatches[needlePart])
+            permMatrix[needleId][hayMapping.circIds[hayPart]].set();
     }
 
-    if(haystack->wireManager()->wires().size()
-            < needle->wireManager()->wires().size())
-        return;
-    if(haystack->getChildrenCst().size() - alreadyImplied.size()
-            < needle->getChildrenCst().size())
+    // Setting the possibly adjacent wires (wireFit + degrees). The needle
+    // wires left out of the mapping are skipped.
+    auto setFit = [&](WireId* hayWire, WireId* needleWire) {
+        size_t needleId = mapping.needle.wireId(needleWire);
+        if(needleId != UNMAPPED)
+            permMatrix[needleId][hayMapping.wireId(hayWire)].set();
+    };
+    if(hayMapping.vertices.size()
+            == hayMapping.wireIds.size() + hayMapping.circIds.size())
+        wireFit.forEachFit(setFit);
+    else
+        wireFit.forEachFit(hayMapping, setFit);
+
+    // Pinning the bound wires to their haystack wire, if it is fit at all
+    for(size_t needleId = 0;
+            !bindings.wires.empty() && needleId < mapping.needle.circBase;
+            ++needleId)
+    {
+        WireId* bound = bindings.wireOf(mapping.needle.vertices[needleId].wire);
+        if(bound == nullptr)
+            continue;
+        size_t hayId = hayMapping.wireId(bound);
+        bool fit = hayId != UNMAPPED && permMatrix[needleId][hayId];
+        permMatrix[needleId].reset();
+        if(fit)
+            permMatrix[needleId][hayId].set();
+    }
+
+    dumpPerm(permMatrix, mapping); // DEBUG
+
+    // First refining
+    if(!ullmannRefine(permMatrix, mapping, hayAdj))
         return;
 
+    // Ullmann's recursion
+    ullmannFind(results, permMatrix, mapping, hayAdj, needle, alreadyImplied,
+            overlapping);
+}
+
+/** Runs `ullmannMatch` with the matrices fitting the mapped haystack's size.
+ * If `overlapping`, the matches may share haystack circuits, and are all
+ * found. */
+void ullmannMatch(vector<MatchResult>& results,
+        const CircuitGroup* needle,
+        const FullMapping& mapping,
+        const Candidates& singleMatches,
+        WireFitTable& wireFit,
+        const DynBitset& alreadyImplied,
+        const Bindings& bindings,
+        bool overlapping)
+{
+    if(useSparseMatrices(mapping.haystack.vertices.size())) {
+        ullmannMatch<SparseMatrix, SparseMatrix>(results, needle, mapping,
+                singleMatches, wireFit, alreadyImplied, bindings,
+                overlapping);
+    }
+    else {
+        ullmannMatch<BitMatrix, BitMatrix>(results, needle, mapping,
+                singleMatches, wireFit, alreadyImplied, bindings,
+                overlapping);
+    }
+}
 
-    map<CircuitTree*, set<CircuitTree*> > singleMatches;
+/// Wires and children of a group within some distance of an anchor child
+struct Region {
+    vector<WireId*> wires;
+    vector<CircuitTree*> circs; ///< The anchor first
+    size_t radius; ///< Distance from the anchor to the farthest vertex
+};
 
-    // Fill single matches
-    {
-        unordered_map<sign_t, set<CircuitTree*> > signatures;
-        for(auto hayPart : haystack->getChildrenCst())
-            signatures[localSign(hayPart)].insert(hayPart);
-        for(auto needlePart : needle->getChildrenCst()) {
-            singleMatches[needlePart] = signatures[localSign(needlePart)];
+/** Breadth-first search of the wires and children of a group, from its child
+ * `anchor`, through the circuit-wire adjacencies. The vertices rejected by
+ * `keepWire` or `keepCirc` are not crossed; the search stops `maxRadius`
+ * edges away from the anchor.
+ *
+ * The reached vertices are marked in `seenWires`, by
+ * `WireManager::uniqueIndex`, and `seenCircs`, by `CircuitTree::childIndex`,
+ * which must be clear beforehand, and can be cleared back from `region`.
+ */
+template<typename KeepWire, typename KeepCirc>
+void exploreRegion(CircuitTree* anchor, size_t maxRadius,
+        const WireManager* manager,
+        KeepWire keepWire, KeepCirc keepCirc,
+        DynBitset& seenWires, DynBitset& seenCircs,
+        Region& region)
+{
+    region.wires.clear();
+    region.circs.clear();
+    region.radius = 0;
+
+    seenCircs[anchor->childIndex()].set();
+    region.circs.push_back(anchor);
+
+    // The vertices at the current distance are the tails of `region`
+    size_t circsFrom = 0, wiresFrom = 0;
+    for(size_t dist = 1; dist <= maxRadius; ++dist) {
+        bool reached = false;
+        if(dist % 2 == 1) { // Circuits to wires
+            size_t circsTo = region.circs.size();
+            for(; circsFrom < circsTo; ++circsFrom) {
+                for(auto wire: region.circs[circsFrom]->io_wires()) {
+                    size_t wirePos = manager->uniqueIndex(wire);
+                    if(seenWires[wirePos] || !keepWire(wire))
+                        continue;
+                    seenWires[wirePos].set();
+                    region.wires.push_back(wire);
+                    reached = true;
+                }
+            }
         }
+        else { // Wires to circuits
+            size_t wiresTo = region.wires.size();
+            for(; wiresFrom < wiresTo; ++wiresFrom) {
+                WireId* wire = region.wires[wiresFrom];
+                for(auto circ = wire->adjacent_begin();
+                        circ != wire->adjacent_end();
+                        ++circ)
+                {
+                    size_t circPos = (*circ)->childIndex();
+                    if(seenCircs[circPos] || !keepCirc(*circ))
+                        continue;
+                    seenCircs[circPos].set();
+                    region.circs.push_back(*circ);
+                    reached = true;
+                }
+            }
+        }
+
+        if(!reached)
+            break;
+        region.radius = dist;
     }
+}
 
-    // Fill wire connections -- computes "fitness" for given wire roles
-    unordered_map<WireId*, WireFit> wireFit;
-    for(const auto& needleMatch: singleMatches) {
-        sign_t cSig = localSign(needleMatch.first);
-        for(const auto& match: needleMatch.second) {
-            int pin = 0;
-            for(auto inp = match->inp_begin(); inp != match->inp_end();
-                    ++inp)
-            {
-                wireFit[*inp].connected(cSig, true, pin);
-                ++pin;
-            }
+/// Clears the marks left by `exploreRegion` in `seenWires` and `seenCircs`
+void clearRegion(const Region& region, const WireManager* manager,
+        DynBitset& seenWires, DynBitset& seenCircs)
+{
+    for(auto wire: region.wires)
+        seenWires[manager->uniqueIndex(wire)].reset();
+    for(auto circ: region.circs)
+        seenCircs[circ->childIndex()].reset();
+}
 
-            pin = 0;
-            for(auto out = match->out_begin(); out != match->out_end();
-                    ++out)
-            {
-                wireFit[*out].connected(cSig, false, pin);
-                ++pin;
+/** Completes `match`, found without the needle wires connected to no child:
+ * maps the needle's inputs and outputs left out of the mapping, to their
+ * bound wire if any. Returns `false`, doing nothing, if some of those inputs
+ * and outputs cannot be mapped. */
+bool completeMatch(MatchResult& match, const CircuitGroup* needle,
+        const WireManager* hayManager, const Bindings& bindings)
+{
+    vector<WireId*> roles;
+    for(auto pin: needle->getInputs())
+        roles.push_back(pin->actual());
+    for(auto pin: needle->getOutputs())
+        roles.push_back(pin->actual());
+    vector<WireId*> wires = match.inputs;
+    wires.insert(wires.end(), match.outputs.begin(), match.outputs.end());
+
+    if(find(wires.begin(), wires.end(), nullptr) != wires.end()) {
+        vector<WireId*> used;
+        for(auto part: match.parts) {
+            WireSpan partWires = part->io_wires();
+            used.insert(used.end(), partWires.begin(), partWires.end());
+        }
+
+        // A needle wire may be both an input and an output
+        vector<pair<WireId*, WireId*> > picked;
+        for(size_t pos = 0; pos < roles.size(); ++pos) {
+            if(wires[pos] != nullptr)
+                continue;
+            for(const auto& pick: picked)
+                if(pick.first == roles[pos])
+                    wires[pos] = pick.second;
+            if(wires[pos] != nullptr)
+                continue;
+
+            size_t pins = roles[pos]->connectedPins().size();
+            auto isFree = [&](WireId* wire) {
+                return wire->connectedPins().size() >= pins
+                    && find_if(used.begin(), used.end(),
+                            [&](WireId* usedWire) {
+                                return *usedWire == *wire;
+                            }) == used.end();
+            };
+            WireId* bound = bindings.wireOf(roles[pos]);
+            if(bound != nullptr) {
+                if(isFree(bound))
+                    wires[pos] = bound;
             }
+            else {
+                for(auto wire: hayManager->wires()) {
+                    if(isFree(wire)) {
+                        wires[pos] = wire;
+                        break;
+                    }
+                }
+            }
+
+            if(wires[pos] == nullptr)
+                return false;
+            used.push_back(wires[pos]);
+            picked.push_back(make_pair(roles[pos], wires[pos]));
         }
+
+        size_t inputs = match.inputs.size();
+        match.inputs.assign(wires.begin(), wires.begin() + inputs);
+        match.outputs.assign(wires.begin() + inputs, wires.end());
     }
+    return true;
+}
 
-    FIND_DEBUG("=== IN %s ===\n", haystack->name().c_str());
+/// Completes the matches of `results` from `from` on, dropping those failing
+void completeMatches(vector<MatchResult>& results, size_t from,
+        const CircuitGroup* needle, const WireManager* hayManager,
+        const Bindings& bindings)
+{
+    auto failed = remove_if(results.begin() + from, results.end(),
+            [&](MatchResult& match) {
+                return !completeMatch(match, needle, hayManager, bindings);
+            });
+    results.erase(failed, results.end());
+}
+
+/** Finds `needle` in `haystack` around anchors: the needle child with the
+ * fewest candidates is picked as an anchor, and Ullmann's algorithm is run,
+ * for each of its candidates, on the part of the haystack within the
+ * anchor's eccentricity in the needle only.
+ *
+ * The needle wires connected to no child are left out, since they match any
+ * haystack wire: those among the needle's inputs and outputs are matched to
+ * the first haystack wire of the right degree not otherwise used by the
+ * match.
+ *
+ * If `overlapping`, every match holding each anchor is found, regardless of
+ * the others; otherwise, the parts of each match are marked in
+ * `alreadyImplied`.
+ *
+ * Returns `false`, doing nothing, if the needle is not connected. */
+bool findAround(vector<MatchResult>& results,
+        const CircuitGroup* needle, const CircuitGroup* haystack,
+        const Candidates& singleMatches,
+        WireFitTable& wireFit,
+        DynBitset& alreadyImplied,
+        const Bindings& bindings,
+        bool overlapping)
+{
+    const vector<CircuitTree*>& hayChildren = haystack->getChildrenCst();
+    const vector<CircuitTree*>& needleChildren = needle->getChildrenCst();
+    const WireManager* hayManager = haystack->wireManager();
+    const WireManager* needleManager = needle->wireManager();
+
+    // The rarest needle child is the anchor
+    size_t anchorPart = 0;
+    for(size_t needlePart = 1; needlePart < singleMatches.size();
+            ++needlePart)
+    {
+        if(singleMatches[needlePart].size()
+                < singleMatches[anchorPart].size())
+            anchorPart = needlePart;
+    }
+
+    // The needle's connected wires, within the anchor's eccentricity
+    Region needleRegion;
+    {
+        DynBitset seenWires(needleManager->wires().size()),
+                  seenCircs(needleChildren.size());
+        exploreRegion(needleChildren[anchorPart], (size_t)-1, needleManager,
+                [](WireId*) { return true; },
+                [](CircuitTree*) { return true; },
+                seenWires, seenCircs, needleRegion);
+        if(needleRegion.circs.size() != needleChildren.size())
+            return false;
+        for(auto wire: needleManager->wires()) {
+            if(!wire->connectedCirc().empty()
+                    && !seenWires[needleManager->uniqueIndex(wire)])
+                return false;
+        }
+    }
 
-    // Filter out the matches that are not connected as needed
+    FullMapping mapping;
+    mapVertices(needle, needleRegion.wires, needleChildren, mapping.needle);
+
+    // Only the candidate children and the fit wires may be part of a match:
+    // the regions need not cross the others
+    vector<DynBitset> isCandidate(needleChildren.size(),
+            DynBitset(hayChildren.size()));
+    DynBitset anyCandidate(hayChildren.size());
+    for(size_t needlePart = 0; needlePart < singleMatches.size();
+            ++needlePart)
     {
-        auto needleMatch = singleMatches.begin();
-        while(needleMatch != singleMatches.end()) {
-            set<CircuitTree*> nMatches;
-            for(const auto& match: needleMatch->second) {
-                if(isMatchFit(match, needleMatch->first, wireFit))
-                    nMatches.insert(match);
+        for(auto hayPart: singleMatches[needlePart]) {
+            isCandidate[needlePart][hayPart].set();
+            anyCandidate[hayPart].set();
+        }
+    }
+    DynBitset anyFit(hayManager->wires().size());
+    wireFit.forEachFit([&](WireId* hayWire, WireId* needleWire) {
+        if(mapping.needle.wireId(needleWire) != UNMAPPED)
+            anyFit[hayManager->uniqueIndex(hayWire)].set();
+    });
+
+    auto keepWire = [&](WireId* wire) {
+        return (bool)anyFit[hayManager->uniqueIndex(wire)];
+    };
+    auto keepCirc = [&](CircuitTree* circ) {
+        size_t hayPart = circ->childIndex();
+        return anyCandidate[hayPart] && !alreadyImplied[hayPart];
+    };
+
+    DynBitset seenWires(hayManager->wires().size()),
+              seenCircs(hayChildren.size());
+    Region region;
+    Candidates regionMatches(needleChildren.size());
+    for(auto anchor: singleMatches[anchorPart]) {
+        if(alreadyImplied[anchor])
+            continue;
+        if(!SearchBudget::spend())
+            break;
+
+        exploreRegion(hayChildren[anchor], needleRegion.radius, hayManager,
+                keepWire, keepCirc, seenWires, seenCircs, region);
+
+        // Restrict the candidates to the region, the anchor to itself
+        bool feasible = region.circs.size() >= needleChildren.size()
+            && region.wires.size() >= needleRegion.wires.size();
+        for(size_t needlePart = 0;
+                feasible && needlePart < needleChildren.size();
+                ++needlePart)
+        {
+            vector<size_t>& matches = regionMatches[needlePart];
+            matches.clear();
+            if(needlePart == anchorPart) {
+                matches.push_back(anchor);
+                continue;
             }
-            if(nMatches.size() > 0) {
-                singleMatches[needleMatch->first] = nMatches;
-                ++needleMatch;
+            for(auto circ: region.circs)
+                if(isCandidate[needlePart][circ->childIndex()])
+                    matches.push_back(circ->childIndex());
+            feasible = !matches.empty();
+        }
+
+        if(feasible) {
+            mapVertices(haystack, region.wires, region.circs,
+                    mapping.haystack);
+            size_t prevMatches = results.size();
+            ullmannMatch(results, needle, mapping, regionMatches, wireFit,
+                    alreadyImplied, bindings, overlapping);
+            unmapVertices(mapping.haystack);
+
+            // Unless overlapping, there is at most one match
+            completeMatches(results, prevMatches, needle, hayManager,
+                    bindings);
+            if(!overlapping && results.size() > prevMatches) {
+                for(auto part: results.back().parts)
+                    alreadyImplied[part->childIndex()].set();
             }
-            else // lighten the data structure
-                needleMatch = singleMatches.erase(needleMatch);
         }
+
+        clearRegion(region, hayManager, seenWires, seenCircs);
     }
+    return true;
+}
 
-    // Ensure there is at least enough matches for a full `needle`
-    for(const auto& child: needle->getChildrenCst())
-        if(singleMatches[child].empty())
-            return;
+/** Appends to `results` a maximum set of pairwise disjoint `occurrences`,
+ * found in a group of `hayChildren` children, within `selectionBudget` (see
+ * `ConflictGraph::maxIndependentSet`) */
+void selectMaximum(vector<MatchResult>& results,
+        vector<MatchResult>& occurrences, size_t hayChildren)
+{
+    // Two occurrences conflict whenever they share some part
+    ConflictGraph conflicts(occurrences.size());
+    vector<vector<size_t> > holding(hayChildren);
+    for(size_t occur = 0; occur < occurrences.size(); ++occur) {
+        for(auto part: occurrences[occur].parts) {
+            vector<size_t>& others = holding[part->childIndex()];
+            for(auto other: others)
+                conflicts.addConflict(occur, other);
+            others.push_back(occur);
+        }
+    }
 
-    // Map vertices (ie. wires and circuits) to IDs
-    FullMapping mapping;
-    mapVertices(needle, mapping.needle);
-    mapVertices(haystack, mapping.haystack);
+    auto deadline = ConflictGraph::Clock::now() + selectionBudget;
+    for(auto occur: conflicts.maxIndependentSet(deadline))
+        results.push_back(move(occurrences[occur]));
+}
 
-    // Determine haystack's adjacencies
-    AdjacencyMatr hayAdj(
-            mapping.haystack.vertices.size(),
-            DynBitset(mapping.haystack.vertices.size()));
-    buildAdjacency(haystack, mapping.haystack, hayAdj);
+/// Checks whether `group`, `depth` levels below its root, is in `scope`
+bool inScope(CircuitGroup* group, const MatchScope& scope, int depth) {
+    if(scope.maxDepth >= 0 && depth > scope.maxDepth)
+        return false;
+    return !scope.filter || scope.filter(group);
+}
 
-    // == Ullman's algorithm ==
-    // Build the permutation matrix (initially not a permutation
-    // The matix is |needle| x |haystack|, and a 1 indicates that we think two
-    // vertices could be matches at a given point.
-    PermMatrix permMatrix(
-            mapping.needle.vertices.size(),
-            DynBitset(mapping.haystack.vertices.size()));
+void findIn(vector<MatchResult>& results,
+        const CircuitGroup* needle, const CircuitGroup* haystack,
+        const MatchScope& scope, int depth)
+{
+    const vector<CircuitTree*>& hayChildren = haystack->getChildrenCst();
+    haystack->leafStore(); // Numbers the children, see `childIndex`
 
-    // Setting the possible adjacent circuits (singleMatches)
-    for(const auto& match: singleMatches) {
-        size_t needleId = mapping.needle.circId[match.first];
-        for(const auto& hayPart: match.second) {
-            size_t hayId = mapping.haystack.circId[hayPart];
-            permMatrix[needleId][hayId].set();
+    // Circuits that are already part of a match result, by child index
+    DynBitset alreadyImplied(hayChildren.size());
+
+    // Recurse in hierarchy
+    for(auto& child: hayChildren) {
+        if(child->circType() != CircuitTree::CIRC_GROUP)
+            continue;
+        CircuitGroup* subgroup = dynamic_cast<CircuitGroup*>(child);
+        if(!inScope(subgroup, scope, depth + 1))
+            continue;
+
+        size_t prevMatches = results.size();
+        findIn(results, needle, subgroup, scope, depth + 1);
+        if(results.size() != prevMatches)
+            alreadyImplied[child->childIndex()].set();
+    }
+    if(SearchBudget::spent())
+        return;
+
+    Bindings unbound;
+    unbound.needleManager = needle->wireManager();
+    findLocal(results, needle, haystack, alreadyImplied, unbound);
+}
+
+void findLocal(vector<MatchResult>& results,
+        const CircuitGroup* needle, const CircuitGroup* haystack,
+        DynBitset& alreadyImplied,
+        const Bindings& bindings)
+{
+    const vector<CircuitTree*>& hayChildren = haystack->getChildrenCst();
+    const vector<CircuitTree*>& needleChildren = needle->getChildrenCst();
+
+    if(haystack->wireManager()->wires().size()
+            < needle->wireManager()->wires().size())
+        return;
+    if(hayChildren.size() - alreadyImplied.count() < needleChildren.size())
+        return;
+
+    // The search below traverses the adjacency of the wires over and over
+    haystack->wireManager()->buildAdjacency();
+    needle->wireManager()->buildAdjacency();
+
+    Candidates singleMatches(needleChildren.size());
+
+    // Fill single matches
+    {
+        // Batch-compute the local signatures before bucketing
+        haystack->signChildren(0);
+        needle->signChildren(0);
+
+        // Haystack children sorted by signature, then by index
+        vector<pair<sign_t, size_t> > signatures;
+        signatures.reserve(hayChildren.size());
+        for(size_t hayPart = 0; hayPart < hayChildren.size(); ++hayPart) {
+            signatures.push_back(
+                    make_pair(localSign(hayChildren[hayPart]), hayPart));
         }
+        sort(signatures.begin(), signatures.end());
+
+        for(size_t needlePart = 0; needlePart < needleChildren.size();
+                ++needlePart)
+        {
+            sign_t sig = localSign(needleChildren[needlePart]);
+            auto match = lower_bound(signatures.begin(), signatures.end(),
+                    make_pair(sig, (size_t)0));
+            for(; match != signatures.end() && match->first == sig; ++match)
+            {
+                if(conformsTo(hayChildren[match->second],
+                            needleChildren[needlePart], bindings))
+                    singleMatches[needlePart].push_back(match->second);
+            }
+        }
+    }
+
+    // Fill wire connections -- computes "fitness" for given wire roles
+    WireFitTable wireFit(needle, haystack, singleMatches);
+
+    FIND_DEBUG("=== IN %s ===\n", haystack->name().c_str());
+
+    // Filter out the matches that are not connected as needed, ensuring
+    // there is at least enough matches for a full `needle`
+    for(size_t needlePart = 0; needlePart < needleChildren.size();
+            ++needlePart)
+    {
+        vector<size_t>& matches = singleMatches[needlePart];
+        auto unfit = remove_if(matches.begin(), matches.end(),
+                [&](size_t match) {
+                    return !isMatchFit(hayChildren[match],
+                            needleChildren[needlePart], wireFit);
+                });
+        matches.erase(unfit, matches.end());
+        if(matches.empty())
+            return;
     }
 
     // Check for dangling wires that can slow down the whole find
@@ -562,48 +1281,194 @@ void findIn(vector<MatchResult>& results,
         }
     }
 
-    // Setting the possibly adjacent wires (wireFit + degrees)
-    // Let's not be clever for now, and (maybe) enhance this part later
-    for(const auto& hayWire: haystack->wireManager()->wires()) {
-        size_t hayId = mapping.haystack.wireId[hayWire];
-
-        for(const auto& needleWire: needle->wireManager()->wires()) {
-            if((hayWire->connectedCirc().size()
-                        >= needleWire->connectedCirc().size())
-                    && (hayWire->connectedPins().size()
-                        >= needleWire->connectedPins().size())
-                    && (
-                        wireFit.find(hayWire) == wireFit.end()
-                        || wireFit[hayWire].fitFor(needleWire)))
-                    /* If hayWire is not in wireFit, that means that the
-                     * given haystack wire was never connected to anything, in
-                     * which case the number of connections already tested are
-                     * enough to know whether this is a potential match or not
-                     */
-            {
-                // Fit for this role
-                size_t needleId = mapping.needle.wireId[needleWire];
-                permMatrix[needleId][hayId].set();
-            }
+    // To select among all the occurrences, they must all be found first
+    bool overlapping = matchSelection == MatchSelection::MAXIMUM;
+    vector<MatchResult> occurrences;
+    vector<MatchResult>& found = overlapping ? occurrences : results;
+
+    size_t hayVertices =
+        haystack->wireManager()->wires().size() + hayChildren.size();
+    if(!useAnchors(hayVertices)
+            || !findAround(found, needle, haystack, singleMatches, wireFit,
+                alreadyImplied, bindings, overlapping))
+    {
+        // Map vertices (ie. wires and circuits) to IDs. When overlapping, the
+        // needle wires connected to no child would yield the same match once
+        // per haystack wire: they are left out, and completed afterwards.
+        FullMapping mapping;
+        if(overlapping) {
+            vector<WireId*> connected;
+            for(auto wire: needle->wireManager()->wires())
+                if(!wire->connectedCirc().empty())
+                    connected.push_back(wire);
+            mapVertices(needle, connected, needleChildren, mapping.needle);
+        }
+        else
+            mapVertices(needle, mapping.needle);
+        mapVertices(haystack, mapping.haystack);
+
+        ullmannMatch(found, needle, mapping, singleMatches, wireFit,
+                alreadyImplied, bindings, overlapping);
+        if(overlapping) {
+            completeMatches(found, 0, needle, haystack->wireManager(),
+                    bindings);
         }
     }
 
-    dumpPerm(permMatrix, mapping); // DEBUG
+    if(overlapping)
+        selectMaximum(results, occurrences, hayChildren.size());
+}
 
-    // First refining
-    if(!ullmannRefine(permMatrix, mapping, hayAdj))
-        return;
+/** Group of the hierarchy of `root` owning the wires of `manager`, or
+ * nullptr */
+const CircuitGroup* groupOf(const WireManager* manager,
+        const CircuitGroup* root)
+{
+    if(root->wireManager() == manager)
+        return root;
+    for(auto child: root->getChildrenCst()) {
+        if(child->circType() != CircuitTree::CIRC_GROUP)
+            continue;
+        const CircuitGroup* group =
+            groupOf(manager, dynamic_cast<CircuitGroup*>(child));
+        if(group != nullptr)
+            return group;
+    }
+    return nullptr;
+}
 
-    // Ullmann's recursion
-    ullmannFind(results, permMatrix, mapping, hayAdj, needle, alreadyImplied);
+/** Resolves `bindings` on `needle` into `resolved`, and returns the group of
+ * the hierarchy of `haystack` they are bound to, or nullptr if they are
+ * bound to several groups, to a circuit outside of the hierarchy or
+ * inconsistently (eg. a needle wire both input and output bound to two
+ * haystack wires).
+ *
+ * @throws MatchBindings::BadBinding if a pin or circuit does not belong to
+ * `needle` */
+const CircuitGroup* resolveBindings(const MatchBindings& bindings,
+        const CircuitGroup* needle, const CircuitGroup* haystack,
+        Bindings& resolved)
+{
+    needle->leafStore(); // Numbers the children, see `childIndex`
+    resolved.needleManager = needle->wireManager();
+    resolved.wires.assign(resolved.needleManager->wires().size(), nullptr);
+    resolved.parts.assign(needle->getChildrenCst().size(), nullptr);
+
+    bool consistent = true;
+    CircuitGroup* group = nullptr;
+    const WireManager* manager = nullptr;
+    for(const auto& pin: bindings.pins) {
+        if(pin.first->group() != needle)
+            throw MatchBindings::BadBinding();
+        WireId*& bound = resolved.wires[
+            resolved.needleManager->uniqueIndex(pin.first->actual())];
+        const WireManager* wireManager = pin.second->manager();
+        WireId* wire =
+            wireManager->wires()[wireManager->uniqueIndex(pin.second)];
+        if(bound != nullptr && bound != wire)
+            consistent = false;
+        if(manager != nullptr && manager != wireManager)
+            consistent = false;
+        bound = wire;
+        manager = wireManager;
+    }
+    for(const auto& part: bindings.parts) {
+        if(part.first->ancestor() != needle)
+            throw MatchBindings::BadBinding();
+        CircuitTree*& bound = resolved.parts[part.first->childIndex()];
+        if(bound != nullptr && bound != part.second)
+            consistent = false;
+        if(group != nullptr && group != part.second->ancestor())
+            consistent = false;
+        bound = part.second;
+        group = part.second->ancestor();
+    }
+    if(!consistent)
+        return nullptr;
+
+    if(group == nullptr)
+        return groupOf(manager, haystack);
+    if(manager != nullptr && manager != group->wireManager())
+        return nullptr;
+    for(CircuitGroup* ancestor = group; ancestor != nullptr;
+            ancestor = ancestor->ancestor())
+    {
+        if(ancestor == haystack)
+            return group;
+    }
+    return nullptr;
 }
 
 }; // namespace
 
-std::vector<MatchResult> matchSubcircuit(CircuitGroup* needle,
-        CircuitGroup* haystack)
+std::vector<MatchResult> matchSubcircuit(const CircuitGroup* needle,
+        const CircuitGroup* haystack)
+{
+    vector<MatchResult> out;
+    findIn(out, needle, haystack, MatchScope(), 0);
+    return out;
+}
+
+std::vector<MatchResult> matchSubcircuit(const CircuitGroup* needle,
+        CircuitGroup* haystack,
+        const MatchScope& scope)
+{
+    vector<CircuitGroup*> roots = scope.roots;
+    if(roots.empty())
+        roots.push_back(haystack);
+
+    vector<MatchResult> out;
+    for(auto root = roots.begin(); root != roots.end(); ++root) {
+        if(find(roots.begin(), root, *root) != root)
+            continue; // Already searched
+
+        // Only search the roots in the hierarchy, and not below another root
+        bool searched = false;
+        for(CircuitGroup* group = *root; group != nullptr;
+                group = group->ancestor())
+        {
+            if(group != *root
+                    && find(roots.begin(), roots.end(), group) != roots.end())
+                break;
+            if(group == haystack) {
+                searched = true;
+                break;
+            }
+        }
+
+        if(searched && inScope(*root, scope, 0))
+            findIn(out, needle, *root, scope, 0);
+    }
+    return out;
+}
+
+std::vector<MatchResult> matchSubcircuit(const CircuitGroup* needle,
+        const CircuitGroup* haystack,
+        const MatchBindings& bindings)
 {
+    if(bindings.empty())
+        return matchSubcircuit(needle, haystack);
+
     vector<MatchResult> out;
-    findIn(out, needle, haystack);
+    Bindings resolved;
+    const CircuitGroup* group = resolveBindings(bindings, needle, haystack,
+            resolved);
+    if(group != nullptr) {
+        DynBitset alreadyImplied(group->getChildrenCst().size());
+        findLocal(out, needle, group, alreadyImplied, resolved);
+    }
     return out;
 }
+
+void setMatchMatrices(MatchMatrices matrices) {
+    matchMatrices = matrices;
+}
+
+void setMatchStrategy(MatchStrategy strategy) {
+    matchStrategy = strategy;
+}
+
+void setMatchSelection(MatchSelection selection, unsigned budgetMs) {
+    matchSelection = selection;
+    selectionBudget = chrono::milliseconds(budgetMs);
+}
@@ -2,9 +2,13 @@
 
 #include "circuitTree.h"
 
+#include <exception>
+#include <functional>
+#include <utility>
 #include <vector>
 
 class CircuitGroup;
+class IOPin;
 
 /** Result of a single circuit match */
 struct MatchResult {
@@ -22,8 +26,126 @@ struct MatchResult {
 /** Finds every match of the components of `needle` in `haystack`, that is,
  * every subgraph of `haystack` formally matching `needle`. The results are
  * always non-overlapping; whenever multiple potential matches overlap, one of
- * them only is arbitrarily picked and returned. */
+ * them only is arbitrarily picked and returned. Neither group is altered,
+ * although their lazily computed state (signatures, …) may be filled.
+ *
+ * The search stops early, returning the matches found so far, if the active
+ * `SearchBudget` runs out (see `searchBudget.h`). */
 std::vector<MatchResult> matchSubcircuit(
-        CircuitGroup* needle,       ///< Subgroup to find
-        CircuitGroup* haystack      ///< Group to be searched in
+        const CircuitGroup* needle,     ///< Subgroup to find
+        const CircuitGroup* haystack    ///< Group to be searched in
         );
+
+/** Partial mapping of a needle onto a haystack, known beforehand, to which
+ * the matches of `matchSubcircuit` must conform: some of the needle's inputs
+ * and outputs are bound to haystack wires, some of its children to haystack
+ * circuits. */
+struct MatchBindings {
+    /** Thrown when a bound pin or circuit does not belong to the needle */
+    class BadBinding : public std::exception {};
+
+    /// Binds the needle input or output `pin` to the haystack wire `wire`
+    void bind(IOPin* pin, WireId* wire) {
+        pins.push_back(std::make_pair(pin, wire));
+    }
+
+    /// Binds the needle child `needlePart` to the haystack circuit `hayPart`
+    void bind(CircuitTree* needlePart, CircuitTree* hayPart) {
+        parts.push_back(std::make_pair(needlePart, hayPart));
+    }
+
+    /// Checks whether nothing is bound
+    bool empty() const { return pins.empty() && parts.empty(); }
+
+    std::vector<std::pair<IOPin*, WireId*> > pins;
+    std::vector<std::pair<CircuitTree*, CircuitTree*> > parts;
+};
+
+/** Same as above, returning only the matches conforming to `bindings`.
+ *
+ * The bound haystack wires and circuits must all belong to the same group, in
+ * the hierarchy of `haystack`, which is then the only group searched: there
+ * is no match otherwise.
+ *
+ * @throws MatchBindings::BadBinding if a bound pin or circuit does not belong
+ * to `needle`.
+ */
+std::vector<MatchResult> matchSubcircuit(
+        const CircuitGroup* needle,
+        const CircuitGroup* haystack,
+        const MatchBindings& bindings
+        );
+
+/** Part of the hierarchy of a haystack searched by `matchSubcircuit`, to
+ * keep the searches of large designs short */
+struct MatchScope {
+    /// Predicate over groups, see `filter`
+    typedef std::function<bool(CircuitGroup*)> GroupFilter;
+
+    MatchScope() : maxDepth(-1) {}
+
+    /** Groups to search, along with their subgroups, instead of the whole
+     * haystack. The groups outside of the haystack's hierarchy are ignored,
+     * and so are those below another one of them. */
+    std::vector<CircuitGroup*> roots;
+
+    /** Depth of the deepest groups searched, below the haystack or the
+     * `roots`, these being at depth 0. Unlimited if negative. */
+    int maxDepth;
+
+    /** If set, only the groups it accepts are searched (eg. by name or
+     * signature); the other ones are skipped along with their subgroups. */
+    GroupFilter filter;
+};
+
+/** Same as above, searching only the groups within `scope` */
+std::vector<MatchResult> matchSubcircuit(
+        const CircuitGroup* needle,
+        CircuitGroup* haystack,
+        const MatchScope& scope
+        );
+
+/** Representation of the candidate sets (permutation matrix) and of the
+ * haystack's adjacency used by `matchSubcircuit` */
+enum class MatchMatrices {
+    DENSE,  ///< Bit matrices (see `BitMatrix`), best for small groups
+    SPARSE, ///< Compressed bitsets (see `SparseBitset`), for large groups
+    AUTO    ///< Picks one of the above for each group, by its size
+};
+
+/** Sets the representation used by `matchSubcircuit`, mostly for
+ * benchmarking. Defaults to `AUTO`. */
+void setMatchMatrices(MatchMatrices matrices);
+
+/** Search strategy of `matchSubcircuit` within each group */
+enum class MatchStrategy {
+    /// Runs Ullmann's algorithm on the whole group at once
+    WHOLE_GROUP,
+    /** Picks the needle child with the fewest candidates as an anchor, and
+     * runs Ullmann's algorithm in the neighbourhood of each of its
+     * candidates only, within the needle's radius around the anchor. Best on
+     * large groups holding few occurrences. */
+    ANCHORED,
+    /// Picks one of the above for each group, by its size
+    AUTO
+};
+
+/** Sets the strategy used by `matchSubcircuit`, mostly for benchmarking.
+ * Defaults to `AUTO`. */
+void setMatchStrategy(MatchStrategy strategy);
+
+/** Selection of the matches of `matchSubcircuit`, which never overlap,
+ * among the occurrences found within each group */
+enum class MatchSelection {
+    /// Keeps each occurrence disjoint from those found before, in search order
+    GREEDY,
+    /** Finds all the occurrences, overlapping or not, and keeps as many
+     * pairwise disjoint ones as possible (see `ConflictGraph`). Slower, and
+     * exact only within the time budget. */
+    MAXIMUM
+};
+
+/** Sets the selection used by `matchSubcircuit`, with a time budget of
+ * `budgetMs` milliseconds for each group, after which `MAXIMUM` settles for
+ * its best selection so far. Defaults to `GREEDY`. */
+void setMatchSelection(MatchSelection selection, unsigned budgetMs = 100);
@@ -28,62 +28,54 @@ class WireId {
             WireId* other;
         };
 
+        /** Iterator over the circuits adjacent to a wire. They are read from
+         * the contiguous adjacency of the `WireManager` when it is up to date
+         * (see `WireManager::buildAdjacency`), and otherwise from the wire's
+         * connected circuits, then the groups of its connected pins. */
         class CircIterator {
-            typedef std::vector<CircuitTree*>::iterator CircIter;
-            typedef std::vector<PinConnection>::iterator PinIter;
-
             public:
-                CircIterator(const CircIter& iter, WireId* parent);
-                CircIterator(const PinIter& iter, WireId* parent) :
-                    pinIter(iter), isCircIter(false), parent(parent) {}
-
-                CircIterator(const CircIterator& oth) {
-                    operator=(oth);
+                CircIterator(CircuitTree* const* circ,
+                        CircuitTree* const* circEnd,
+                        const PinConnection* pin) :
+                    circ(circ), circEnd(circEnd), pin(pin) {}
+
+                CircuitTree* operator*() const {
+                    if(circ != circEnd)
+                        return *circ;
+                    return pinGroup();
                 }
-                void operator=(const CircIterator& oth) {
-                    isCircIter = oth.isCircIter;
-                    if(isCircIter)
-                        circIter = oth.circIter;
+                CircIterator& operator++() {
+                    if(circ != circEnd)
+                        ++circ;
                     else
-                        pinIter = oth.pinIter;
+                        ++pin;
+                    return *this;
                 }
-
-                CircIterator& operator++();
-
-                CircuitTree* operator*() const;
-
                 bool operator==(const CircIterator& oth) const {
-                    return parent == oth.parent &&
-                        isCircIter == oth.isCircIter &&
-                        ((isCircIter && circIter == oth.circIter)
-                         || (!isCircIter && pinIter == oth.pinIter));
+                    return circ == oth.circ && pin == oth.pin;
                 }
                 bool operator!=(const CircIterator& oth) const {
-                    return !operator==(oth);
+                    return !(*this == oth);
                 }
 
-
             private:
-                union {
-                    CircIter circIter;
-                    PinIter pinIter;
-                };
-                bool isCircIter;
-                WireId* parent;
+                CircuitTree* pinGroup() const;
+
+                CircuitTree* const* circ;
+                CircuitTree* const* circEnd;
+                const PinConnection* pin;
         };
 
         class NoSuchConnection : public std::exception {};
 
 		/**
-		 * Basic constructor
+		 * Basic constructor. The wire's data lives in the table of its
+		 * `WireManager`, which should be the only one to create wires.
 		 *
-		 * @param id Id of the wire
-		 * @param name Convenience name for the wire
+		 * @param index Index of the wire in its manager's wire table
          * @param manager the `WireManager` used to create this wire
 		 */
-		WireId(size_t id, const std::string& name, WireManager* manager);
-
-        ~WireId();
+		WireId(size_t index, WireManager* manager);
 
 		/** Id-based equality */
 		bool operator==(const WireId& oth) const;
@@ -136,9 +128,9 @@ class WireId {
          * to this wire are considered (instead of considering the actual leaf
          * the wire is connected to inside this group).
          *
-         * **NOTE**: the behaviour of this iterator is undefined when the
-         * parent `WireId` is altered during the iteration. This includes
-         * connecting more gates, merging this wire, … */
+         * **NOTE**: the behaviour of this iterator is undefined when any
+         * wire of the parent `WireManager` is altered during the iteration.
+         * This includes connecting more gates, merging wires, … */
         CircIterator adjacent_begin();
 
         /** Get a past-the-end iterator to adjacent circuits for this group.
@@ -147,49 +139,34 @@ class WireId {
 
         /** Get the list of circuits connected to that wire, possibly through
          * other wires. Must perform a DFS through connected wires and create
-         * the list on-the-fly, which might be a bit slow for heavy use. */
+         * the list on-the-fly, which might be a bit slow for heavy use: see
+         * `CircuitGroup::netIndex` for repeated queries. */
         std::vector<CircuitTree*> connected();
 
         /** Get the name of this wire */
-        const std::string& name() { return inner()->name; }
-
-        /** Get the name of this wire (const version) */
-        const std::string& name() const { return inner()->name; }
+        const std::string& name() const;
 
         /** Get this wire's display unique name */
         std::string uniqueName();
 
+        /** Get this wire's id, unique within its `WireManager`. Merged wires
+         * share the same id. */
+        size_t id() const;
+
+        /** Get the index of this wire in its manager's wire table. Unlike
+         * `id`, it is not shared by merged wires. */
+        size_t index() const { return index_; }
+
+        /** Get the `WireManager` this wire belongs to */
+        WireManager* manager() const { return manager_; }
+
 	private:
         void walkConnected(std::unordered_set<CircuitTree*>& curConnected,
                 std::unordered_set<WireId>& seenWires,
                 WireId* curWire);
 
-        struct Inner {
-            size_t id;
-            std::string name;
-            WireManager* manager;
-            std::vector<CircuitTree*> connected;
-            std::vector<PinConnection> connectedPins;
-        };
-
-        void merge(WireId* other);
-        void rename(const std::string& nName) { inner()->name = nName; }
-
-        WireId* ufRoot();
-        inline Inner* inner() { return ufRoot()->end; };
-        const Inner* inner() const;
-
-        union {
-            Inner* end;
-            WireId* chain;
-        };
-        bool isEndpoint;
-        unsigned short ufDepth;
-
-    friend WireManager; // set the wire's name
-    friend struct std::hash<WireId>;
-    friend struct std::hash<WireId*>;
-    friend struct HashWirePtr;
+        WireManager* manager_;
+        size_t index_;
 };
 
 namespace std {
@@ -197,7 +174,7 @@ namespace std {
         typedef WireId argument_type;
         typedef std::size_t result_type;
         result_type operator()(const argument_type& wire) const {
-            return wire.inner()->id;
+            return wire.id();
         }
     };
 
@@ -205,7 +182,7 @@ namespace std {
         typedef WireId* argument_type;
         typedef std::size_t result_type;
         result_type operator()(const argument_type& wire) const {
-            return wire->inner()->id;
+            return wire->id();
         }
     };
 
@@ -1,49 +1,107 @@
 #include "wireManager.h"
+#include "circuitGroup.h"
+
+#include <algorithm>
 using namespace std;
 
 size_t WireManager::nextId = 0;
 
-WireManager::WireManager() : id_(nextId++)
+/// Checks whether `name` was automatically generated
+static bool isAutoName(name_id_t name) {
+    if(name == nameInterner::NO_NAME)
+        return true;
+    const string& str = nameInterner::str(name);
+    return str.size() == 0 || str[0] == ' ';
+}
+
+WireManager::WireManager() : adjOutdated(true), id_(nextId++)
 {}
 
 WireManager::~WireManager() {
     for(auto wire: wireById)
         delete wire;
+    for(auto name: heldNames)
+        nameInterner::release(name);
+}
+
+name_id_t WireManager::internName(const std::string& name) const {
+    name_id_t nameId = nameInterner::intern(name);
+    heldNames.push_back(nameId);
+    return nameId;
 }
 
 WireId* WireManager::fresh(const std::string& name) {
     if(hasWire(name))
         throw AlreadyDefined(name.c_str());
-    wireById.push_back(new WireId(wireById.size(), name, this));
-    wireByName[name] = wireById.back();
+    name_id_t nameId = internName(name);
+    WireId* out = freshWire(nameId);
+    wireByName[nameId] = out;
+    return out;
+}
+
+WireId* WireManager::fresh() {
+    return freshWire(nameInterner::NO_NAME);
+}
+
+WireId* WireManager::freshWire(name_id_t name) {
+    size_t index = wireById.size();
+    wireById.push_back(new WireId(index, this));
+    ufParent.push_back(index);
+    ufRank.push_back(0);
+    wireNames.push_back(name);
+    wireCircs.emplace_back();
+    wireCircSlots.emplace_back();
+    wirePins.emplace_back();
+    uniquePos.push_back(uniqueWires.size());
+    uniqueWires.push_back(wireById.back());
+    adjOutdated = true;
     return wireById.back();
 }
 
 bool WireManager::hasWire(const std::string& name) {
-    return wireByName.find(name) != wireByName.end();
+    name_id_t nameId;
+    return nameInterner::lookup(name, nameId)
+        && wireByName.find(nameId) != wireByName.end();
 }
 
 bool WireManager::hasWire(size_t id) {
     return wireById.size() > id; // `id` is unsigned
 }
 
-std::vector<WireId*> WireManager::wires() const {
-    vector<WireId*> out;
-    for(const auto& wire: allWires()) {
-        if(wire->isEndpoint)
-            out.push_back(wire);
+size_t WireManager::rootOf(size_t index) const {
+    size_t root = index;
+    while(ufParent[root] != root)
+        root = ufParent[root];
+    while(ufParent[index] != root) { // Path compression
+        size_t next = ufParent[index];
+        ufParent[index] = root;
+        index = next;
     }
-    return out;
+    return root;
+}
+
+bool WireManager::isAnonymous(size_t id) const {
+    return isAutoName(wireNames[rootOf(id)]);
+}
+
+void WireManager::freeze() {
+    for(size_t index = 0; index < wireById.size(); ++index)
+        rootOf(index);
+    buildAdjacency();
+    for(auto wire: uniqueWires)
+        wireName(wire->id());
 }
 
 WireId* WireManager::wire(const std::string& name, bool dontCreate) {
-    if(!hasWire(name)) {
-        if(dontCreate)
-            throw NotDefined(name.c_str());
-        return fresh(name);
+    name_id_t nameId;
+    if(nameInterner::lookup(name, nameId)) {
+        auto found = wireByName.find(nameId);
+        if(found != wireByName.end())
+            return found->second;
     }
-    else
-        return wireByName[name];
+    if(dontCreate)
+        throw NotDefined(name.c_str());
+    return fresh(name);
 }
 
 WireId* WireManager::wire(size_t id) {
@@ -56,7 +114,7 @@ void WireManager::rename(size_t id, const std::string& newName) {
     if(!hasWire(id))
         throw NotDefined("[id]");
 
-    rename(wireById[id]->name(), newName);
+    renameWire(wireById[id], newName);
 }
 
 void WireManager::rename(const std::string& curName,
@@ -65,15 +123,171 @@ void WireManager::rename(const std::string& curName,
     if(!hasWire(curName))
         throw NotDefined(curName.c_str());
 
-    WireId* curWire = wireByName[curName];
-    if(hasWire(newName)) {
-        WireId* mergeWith = wire(newName);
-        wireByName.erase(curName);
-        curWire->merge(mergeWith);
+    name_id_t curNameId;
+    nameInterner::lookup(curName, curNameId);
+    renameWire(wireByName[curNameId], newName);
+}
+
+void WireManager::renameWire(WireId* curWire, const std::string& newName) {
+    name_id_t curName = wireNames[curWire->id()];
+    name_id_t newNameId = internName(newName);
+    if(newNameId == curName)
+        return;
+
+    auto mergeWith = wireByName.find(newNameId);
+    if(mergeWith != wireByName.end()) {
+        if(curName != nameInterner::NO_NAME)
+            wireByName.erase(curName);
+        merge(curWire, mergeWith->second);
     }
     else {
-        curWire->rename(newName);
-        wireByName.erase(curName);
-        wireByName[newName] = curWire;
+        // The old name still designates the wire, eg. for the pins of
+        // sub-groups referring to it after an assignment `x = s`
+        wireNames[curWire->id()] = newNameId;
+        wireByName[newNameId] = curWire;
+    }
+}
+
+const std::string& WireManager::wireName(size_t id) const {
+    if(wireNames[id] == nameInterner::NO_NAME) {
+        name_id_t name = internName(string(" _wire_") + to_string(id));
+        wireNames[id] = name;
+        wireByName.emplace(name, wireById[id]);
+    }
+    return nameInterner::str(wireNames[id]);
+}
+
+void WireManager::merge(WireId* keptWire, WireId* mergedWire) {
+    size_t kept = keptWire->id(), merged = mergedWire->id();
+    if(kept == merged)
+        return;
+    if(ufRank[merged] > ufRank[kept])
+        swap(kept, merged);
+
+    // Merge connected pins and circuits, moving their back-indices along
+    for(size_t pos = 0; pos < wireCircs[merged].size(); ++pos) {
+        CircuitTree* circ = wireCircs[merged][pos];
+        size_t slot = wireCircSlots[merged][pos];
+        circ->wireSlots[slot].pos = wireCircs[kept].size();
+        wireCircs[kept].push_back(circ);
+        wireCircSlots[kept].push_back(slot);
+    }
+    for(const auto& pin: wirePins[merged]) {
+        pin.pin->_slot = wirePins[kept].size();
+        wirePins[kept].push_back(pin);
+    }
+    vector<CircuitTree*>().swap(wireCircs[merged]);
+    vector<size_t>().swap(wireCircSlots[merged]);
+    vector<WireId::PinConnection>().swap(wirePins[merged]);
+
+    // Merge names if one was auto-generated
+    if(isAutoName(wireNames[kept]) && !isAutoName(wireNames[merged]))
+        wireNames[kept] = wireNames[merged];
+    wireNames[merged] = nameInterner::NO_NAME;
+
+    // Swap the merged wire out of the unique wires
+    size_t mergedPos = uniquePos[merged];
+    uniqueWires[mergedPos] = uniqueWires.back();
+    uniquePos[uniqueWires[mergedPos]->id()] = mergedPos;
+    uniqueWires.pop_back();
+
+    ufParent[merged] = kept;
+    if(ufRank[merged] == ufRank[kept])
+        ++ufRank[kept];
+    adjOutdated = true;
+}
+
+void WireManager::connect(size_t id, CircuitTree* circ) {
+    circ->wireSlots.push_back(
+            CircuitTree::WireSlot(wireById[id], wireCircs[id].size()));
+    wireCircs[id].push_back(circ);
+    wireCircSlots[id].push_back(circ->wireSlots.size() - 1);
+    adjOutdated = true;
+}
+
+void WireManager::connect(size_t id, const WireId::PinConnection& pin) {
+    pin.pin->_slot = wirePins[id].size();
+    wirePins[id].push_back(pin);
+    adjOutdated = true;
+}
+
+void WireManager::disconnect(size_t id, CircuitTree* circ) {
+    // A circuit is connected to a handful of wires: look for the slot
+    // connecting it to this wire.
+    vector<CircuitTree::WireSlot>& slots = circ->wireSlots;
+    size_t slot = 0;
+    while(slot < slots.size() && slots[slot].wire->id() != id)
+        ++slot;
+    if(slot == slots.size())
+        throw WireId::NoSuchConnection();
+
+    // Swap-and-pop the connection out of the wire
+    vector<CircuitTree*>& conns = wireCircs[id];
+    vector<size_t>& connSlots = wireCircSlots[id];
+    size_t pos = slots[slot].pos;
+    conns[pos] = conns.back();
+    connSlots[pos] = connSlots.back();
+    conns[pos]->wireSlots[connSlots[pos]].pos = pos;
+    conns.pop_back();
+    connSlots.pop_back();
+
+    // Swap-and-pop the slot out of the circuit
+    slots[slot] = slots.back();
+    slots.pop_back();
+    if(slot < slots.size()) {
+        const CircuitTree::WireSlot& moved = slots[slot];
+        moved.wire->manager()->wireCircSlots[moved.wire->id()][moved.pos] =
+            slot;
+    }
+    adjOutdated = true;
+}
+
+void WireManager::disconnect(size_t id, IOPin* pin) {
+    vector<WireId::PinConnection>& conns = wirePins[id];
+    size_t pos = pin->_slot;
+    if(pos >= conns.size() || conns[pos].pin != pin)
+        throw WireId::NoSuchConnection();
+    conns[pos] = conns.back();
+    conns[pos].pin->_slot = pos;
+    conns.pop_back();
+    adjOutdated = true;
+}
+
+WireId::CircIterator WireManager::adjacent_begin(size_t id) const {
+    if(adjOutdated) {
+        const vector<CircuitTree*>& circs = wireCircs[id];
+        return WireId::CircIterator(circs.data(), circs.data() + circs.size(),
+                wirePins[id].data());
+    }
+    CircuitTree* const* circs = adjCircs.data() + adjOffsets[id];
+    return WireId::CircIterator(circs, adjCircs.data() + adjOffsets[id + 1],
+            nullptr);
+}
+
+WireId::CircIterator WireManager::adjacent_end(size_t id) const {
+    if(adjOutdated) {
+        const vector<CircuitTree*>& circs = wireCircs[id];
+        const vector<WireId::PinConnection>& pins = wirePins[id];
+        return WireId::CircIterator(circs.data() + circs.size(),
+                circs.data() + circs.size(), pins.data() + pins.size());
+    }
+    CircuitTree* const* circsEnd = adjCircs.data() + adjOffsets[id + 1];
+    return WireId::CircIterator(circsEnd, circsEnd, nullptr);
+}
+
+void WireManager::buildAdjacency() const {
+    if(!adjOutdated)
+        return;
+
+    adjOffsets.resize(wireById.size() + 1);
+    adjCircs.clear();
+    for(size_t id = 0; id < wireById.size(); ++id) {
+        adjOffsets[id] = adjCircs.size();
+        adjCircs.insert(adjCircs.end(),
+                wireCircs[id].begin(), wireCircs[id].end());
+        for(const auto& pin: wirePins[id])
+            adjCircs.push_back(pin.pin->group());
     }
+    adjOffsets[wireById.size()] = adjCircs.size();
+    adjOutdated = false;
 }
@@ -3,6 +3,10 @@
  *
  * Allocates fresh wire IDs, finds previously defined wire IDs to establish
  * connections, …
+ *
+ * The wires' data is stored in a table indexed by wire index: the `WireId`s
+ * are only handles to a row of this table. Merged wires are tracked by a
+ * union-find over the indices, the root of a wire's class being its id.
  */
 
 #pragma once
@@ -12,6 +16,7 @@
 #include <vector>
 #include <unordered_map>
 
+#include "nameInterner.h"
 #include "wireId.h"
 
 class WireManager {
@@ -50,6 +55,13 @@ class WireManager {
          */
         WireId* fresh(const std::string& name);
 
+        /**
+         * Allocates a fresh, anonymous wire. Its name, starting with a space,
+         * is only generated if it is ever needed, eg. when the wire is
+         * printed.
+         */
+        WireId* fresh();
+
         /**
          * Checks the existence of a given wire
          */
@@ -62,8 +74,21 @@ class WireManager {
         /// Returns *all* wires, including the merged ones
         const std::vector<WireId*>& allWires() const { return wireById; }
 
-        /// Returns a vector of unique wires
-        std::vector<WireId*> wires() const;
+        /** Returns the unique wires, that is, the wires that were not merged
+         * into another one. This is a live view of the manager's wires,
+         * updated as wires are created or merged: merging wires changes its
+         * order. */
+        const std::vector<WireId*>& wires() const { return uniqueWires; }
+
+        /** Get the position of `wire` in `wires()`, which is dense in
+         * `[0, wires().size())`. Merged wires share the same position. */
+        size_t uniqueIndex(const WireId* wire) const {
+            return uniquePos[wire->id()];
+        }
+
+        /** Get the index of the representative of the wire at `index`, that
+         * is, the id of this wire. */
+        size_t rootOf(size_t index) const;
 
         /**
          * Retrieves an existing wire, or creates it as a fresh one if it does
@@ -94,14 +119,87 @@ class WireManager {
          * @throws NotDefined if there is no such wire. */
         void rename(size_t id, const std::string& newName);
 
+        /** Checks whether the wire `id` is anonymous, that is, whether its
+         * name was (or would be) automatically generated */
+        bool isAnonymous(size_t id) const;
+
+        /** Builds the contiguous adjacency of the wires, from which
+         * `WireId::adjacent_begin` reads until this manager is altered
+         * again. Altering the manager does not rebuild it: the adjacency is
+         * read from the wires' connections meanwhile. This runs in time
+         * linear in the number of connections, and is meant to be called
+         * before intensive traversals. */
+        void buildAdjacency() const;
+
+        /** Precomputes everything that is otherwise computed lazily: fully
+         * compresses the union-find, builds the adjacency of the wires and
+         * generates the names of the anonymous wires. Until this manager is
+         * altered again, querying it (`rootOf`, `wires`, `WireId::name`,
+         * `WireId::adjacent_begin`, …) does not write anything, and is thus
+         * safe from several threads at once. */
+        void freeze();
+
         /** Get this wire manager's unique id */
         size_t id() const { return id_; }
 
     private:
+        /** Interns `name`, holding a reference to it until this manager is
+         * destroyed */
+        name_id_t internName(const std::string& name) const;
+
+        /// Allocates a fresh wire named `name`, which may be `NO_NAME`
+        WireId* freshWire(name_id_t name);
+
+        /// Renames `curWire` to `newName`, merging it if needed
+        void renameWire(WireId* curWire, const std::string& newName);
+
+        /** Get the name of the wire `id`, generating it if the wire is
+         * anonymous */
+        const std::string& wireName(size_t id) const;
+
+        /// Merges the wire `merged` into `kept`
+        void merge(WireId* kept, WireId* merged);
+
+        void connect(size_t id, CircuitTree* circ);
+        void connect(size_t id, const WireId::PinConnection& pin);
+        void disconnect(size_t id, CircuitTree* circ);
+        void disconnect(size_t id, IOPin* pin);
+
+        /// Adjacent circuits of the wire `id`, see `WireId::adjacent_begin`
+        WireId::CircIterator adjacent_begin(size_t id) const;
+        /// Past-the-end of `adjacent_begin`
+        WireId::CircIterator adjacent_end(size_t id) const;
+
+        // Wire table, indexed by wire index. The names and connections are
+        // only relevant for the roots of the union-find.
         std::vector<WireId*> wireById;
-        std::unordered_map<std::string, WireId*> wireByName;
+        mutable std::vector<size_t> ufParent;
+        std::vector<unsigned short> ufRank;
+        mutable std::vector<name_id_t> wireNames;
+        std::vector<std::vector<CircuitTree*> > wireCircs;
+        /// Position of each connection in its circuit's `wireSlots`
+        std::vector<std::vector<size_t> > wireCircSlots;
+        std::vector<std::vector<WireId::PinConnection> > wirePins;
+
+        /// Handles of the union-find roots, see `wires()`
+        std::vector<WireId*> uniqueWires;
+        /// Position of each root in `uniqueWires`
+        std::vector<size_t> uniquePos;
+
+        /** Adjacent circuits of every wire, in compressed sparse row form:
+         * the circuits adjacent to the wire `id` lie in `adjCircs`, between
+         * `adjOffsets[id]` and `adjOffsets[id + 1]`, unless outdated. */
+        mutable std::vector<size_t> adjOffsets;
+        mutable std::vector<CircuitTree*> adjCircs;
+        mutable bool adjOutdated;
+
+        mutable std::unordered_map<name_id_t, WireId*> wireByName;
+        /// Names interned by `internName`, released on destruction
+        mutable std::vector<name_id_t> heldNames;
 
         static size_t nextId;
         size_t id_;
+
+    friend WireId;
 };
 
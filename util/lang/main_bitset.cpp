@@ -0,0 +1,90 @@
+/** DynBitset kernels check.
+ *
+ * Runs the word-wise operations of `DynBitset` (`count`, `findFirst`,
+ * `findNext`, `intersects`, the bitwise operators, …) on random bitsets whose
+ * sizes are not multiples of the word size, once with the SIMD kernels and
+ * once with the scalar ones (see `DynBitset::setSimdEnabled`), and compares
+ * both with a bit-by-bit computation.
+ *
+ * Exits with a non-zero status if any result differs.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "dyn_bitset.h"
+using namespace std;
+
+/// Results of the operations on `left` and `right`, as a single string
+static string results(const DynBitset& left, const DynBitset& right) {
+    string out = to_string(left.count()) + " " + to_string(left.findFirst())
+        + " " + to_string(left.any()) + " " + to_string(left.intersects(right))
+        + " " + to_string(left.anyOver(left.size() / 2)) + " |";
+    for(size_t pos = left.findFirst(); pos < left.size();
+            pos = left.findNext(pos))
+        out += " " + to_string(pos);
+    out += " | " + (left & right).dump() + " " + (left | right).dump()
+        + " " + (left ^ right).dump() + " " + to_string((~left).count());
+    return out;
+}
+
+/// Same as `results`, bit by bit
+static string expectedResults(const DynBitset& left, const DynBitset& right) {
+    size_t count = 0, first = left.size();
+    bool intersects = false, anyOver = false;
+    string positions;
+    for(size_t pos = 0; pos < left.size(); ++pos) {
+        if(!left[pos])
+            continue;
+        ++count;
+        first = min(first, pos);
+        intersects = intersects || right[pos];
+        anyOver = anyOver || pos >= left.size() / 2;
+        positions += " " + to_string(pos);
+    }
+    return to_string(count) + " " + to_string(first) + " "
+        + to_string(count > 0) + " " + to_string(intersects) + " "
+        + to_string(anyOver) + " |" + positions + " | "
+        + (left & right).dump() + " " + (left | right).dump() + " "
+        + (left ^ right).dump() + " " + to_string(left.size() - count);
+}
+
+int main() {
+    const size_t sizes[] = { 1, 63, 65, 127, 200, 257, 511, 1000, 4097 };
+    const double densities[] = { 0., 0.002, 0.05, 0.5, 1. };
+    mt19937 rng(42);
+
+    size_t checks = 0, failures = 0;
+    for(size_t size: sizes) {
+        for(double density: densities) {
+            bernoulli_distribution bit(density);
+            DynBitset left(size), right(size);
+            for(size_t pos = 0; pos < size; ++pos) {
+                if(bit(rng))
+                    left[pos] = true;
+                if(bit(rng))
+                    right[pos] = true;
+            }
+
+            DynBitset::setSimdEnabled(true);
+            string simd = results(left, right);
+            DynBitset::setSimdEnabled(false);
+            string scalar = results(left, right);
+            string expected = expectedResults(left, right);
+
+            ++checks;
+            if(simd != scalar || scalar != expected) {
+                cerr << "Mismatch on " << size << " bits, density "
+                     << density << endl;
+                ++failures;
+            }
+        }
+    }
+    DynBitset::setSimdEnabled(true);
+
+    cout << checks - failures << "/" << checks << " bitsets agree ("
+         << (DynBitset::simdAvailable() ? "SIMD" : "no SIMD") << ")" << endl;
+    return failures == 0 ? 0 : 1;
+}
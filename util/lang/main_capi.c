@@ -1,6 +1,17 @@
 #include <stdio.h>
 #include <c_api/isomatch.h>
 
+static int count_matches(match_results* res) {
+    int matches = 0;
+    for(; res != NULL; res = res->next)
+        ++matches;
+    return matches;
+}
+
+static int skip_group(circuit_handle group, void* skipped) {
+    return group != skipped;
+}
+
 int main() {
     // Let's hardcode a circuit \o/
 
@@ -38,7 +49,7 @@ int main() {
     build_tristate(g_root, "p2", "mux1out", "p1");
     build_tristate(g_root, "p3", "mux1out", "np1");
 
-    printf("%lX\t", sign(g_root));
+    printf("%lX\t", (unsigned long)sign(g_root));
     fflush(stdout); // Sync with stderr (which is unbuffered)
 
     circuit_handle c_mux2_not = build_comb(g_root);
@@ -47,13 +58,13 @@ int main() {
     circuit_handle alt_tri_1 = build_tristate(g_root, "p2", "mux1out_", "p1_");
     circuit_handle alt_tri_2 =build_tristate(g_root, "p3", "mux1out_", "np1_");
 
-    printf("%lX\t", sign(g_root));
+    printf("%lX\t", (unsigned long)sign(g_root));
 
     isom_unplug_circuit(c_mux2_not);
     isom_unplug_circuit(alt_tri_1);
     isom_unplug_circuit(alt_tri_2);
 
-    printf("%lX\n", sign(g_root));
+    printf("%lX\n", (unsigned long)sign(g_root));
 
     circuit_handle g_needle = build_group("needle_mux");
     build_group_add_input(g_needle, "a", "a");
@@ -67,14 +78,77 @@ int main() {
     build_tristate(g_needle, "a", "out", "sel");
     build_tristate(g_needle, "b", "out", "nsel");
 
-    match_results* res = subcircuit_find(g_needle, g_root);
-    match_results* cRes = res;
-    int matches = 0;
-    while(cRes != NULL) {
-        cRes = cRes->next;
-        ++matches;
+    // Both muxes are directly in `g_root`, none in `g_sub`
+    circuit_list sub_only = { g_sub, NULL };
+    match_results* scoped[] = {
+        subcircuit_find_scoped(g_needle, g_root, NULL, 0, NULL, NULL),
+        subcircuit_find_scoped(g_needle, g_root, &sub_only, -1, NULL, NULL),
+        subcircuit_find_scoped(g_needle, g_root, NULL, -1, skip_group, g_root)
+    };
+    int scoped_matches[] = { 2, 0, 0 };
+    int scope_failures = 0;
+    for(int scope = 0; scope < 3; ++scope) {
+        if(count_matches(scoped[scope]) != scoped_matches[scope]) {
+            fprintf(stderr, "Bad scoped find #%d\n", scope);
+            ++scope_failures;
+        }
+        free_match_results(scoped[scope]);
+    }
+
+    // A single search node is not enough to find both muxes; a cancelled
+    // budget stops the search right away
+    budget_handle budgets[] = {
+        isom_budget_new(0, 0),
+        isom_budget_new(0, 1),
+        isom_budget_new(0, 0)
+    };
+    isom_budget_cancel(budgets[2]);
+    int budget_statuses[] = {
+        ISOM_SEARCH_COMPLETE, ISOM_SEARCH_EXHAUSTED, ISOM_SEARCH_CANCELLED
+    };
+    int budget_matches[] = { 2, -1, 0 };
+    int budget_failures = 0;
+    for(int budget = 0; budget < 3; ++budget) {
+        match_results* found =
+            subcircuit_find_budgeted(g_needle, g_root, budgets[budget]);
+        int matches = count_matches(found);
+        if(isom_budget_status(budgets[budget]) != budget_statuses[budget]
+                || (budget_matches[budget] >= 0
+                    && matches != budget_matches[budget])
+                || matches > 2)
+        {
+            fprintf(stderr, "Bad budgeted find #%d\n", budget);
+            ++budget_failures;
+        }
+        free_match_results(found);
+    }
+    if(isom_equals(g_root, g_root, budgets[0]) != 1
+            || isom_budget_status(budgets[0]) != ISOM_SEARCH_COMPLETE
+            || isom_equals(g_root, g_root, NULL) != 1)
+    {
+        fprintf(stderr, "Bad equality check\n");
+        ++budget_failures;
     }
-    printf("%d MUX\n", matches);
+    for(int budget = 0; budget < 3; ++budget)
+        isom_budget_free(budgets[budget]);
+
+    // Both handles share the same node, which must survive the release of
+    // either of them
+    expr_handle shared_var0 = build_expr_var(0);
+    free_expression(build_expr_var(0));
+    circuit_handle g_shared = build_group("shared");
+    build_group_add_input(g_shared, "inp", "inp");
+    circuit_handle c_shared = build_comb(g_shared);
+    build_comb_add_input(c_shared, "inp");
+    expr_handle shared_not = build_expr_unop(UNot, shared_var0);
+    build_comb_add_output(c_shared, "out", shared_not);
+    free_expression(shared_not);
+    free_expression(shared_var0);
+    sign(g_shared);
+    free_circuit(g_shared);
+
+    match_results* res = subcircuit_find(g_needle, g_root);
+    printf("%d MUX\n", count_matches(res));
 
     free_match_results(res);
 
@@ -86,6 +160,9 @@ int main() {
     // saved
     free_circuit(g_needle);
 
-    return 0;
+    free_expression(expr_not0);
+    free_expression(c_sub_expr);
+
+    return scope_failures == 0 && budget_failures == 0 ? 0 : 1;
 }
 
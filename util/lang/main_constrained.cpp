@@ -0,0 +1,82 @@
+/** Constrained subcircuit search check.
+ *
+ * Searches the given needle in the given haystack, then searches it again
+ * for each match, with the needle's outputs bound to the match's outputs,
+ * and then also its first child bound to the match's first part (see
+ * `MatchBindings`). Every constrained search must find matches conforming to
+ * the bindings, and only those. The children of every group are first
+ * reordered through `CircuitGroup::getChildren`, which must not affect the
+ * searches.
+ *
+ * Exits with a non-zero status if it is not the case.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include "aux.h"
+using namespace std;
+
+/// Checks whether `match` has the outputs `outputs`
+static bool hasOutputs(const MatchResult& match,
+        const vector<WireId*>& outputs)
+{
+    if(match.outputs.size() != outputs.size())
+        return false;
+    for(size_t pos = 0; pos < outputs.size(); ++pos)
+        if(!(*match.outputs[pos] == *outputs[pos]))
+            return false;
+    return true;
+}
+
+/// Reverses the order of the children of every group under `group`
+static void reverseChildren(CircuitGroup* group) {
+    vector<CircuitTree*>& children = group->getChildren();
+    reverse(children.begin(), children.end());
+    for(auto child: children) {
+        if(child->circType() == CircuitTree::CIRC_GROUP)
+            reverseChildren(static_cast<CircuitGroup*>(child));
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc != 3) {
+        cerr << "Bad arguments. Usage:\n" << argv[0]
+             << " [haystack.circ] [needle.circ]" << endl;
+        return 1;
+    }
+
+    CircuitGroup* haystack = parse(argv[1]);
+    CircuitGroup* needle = parse(argv[2]);
+    reverseChildren(needle);
+    reverseChildren(haystack);
+
+    vector<MatchResult> matches = haystack->find(needle);
+    size_t failures = 0;
+    for(const auto& match: matches) {
+        MatchBindings bindings;
+        for(size_t out = 0; out < needle->getOutputs().size(); ++out)
+            bindings.bind(needle->getOutputs()[out], match.outputs[out]);
+
+        vector<MatchResult> bound = haystack->find(needle, bindings);
+        bool agree = !bound.empty();
+        for(const auto& boundMatch: bound)
+            agree = agree && hasOutputs(boundMatch, match.outputs);
+
+        bindings.bind(needle->getChildren()[0], match.parts[0]);
+        bound = haystack->find(needle, bindings);
+        agree = agree && bound.size() == 1
+            && bound[0].parts[0] == match.parts[0]
+            && hasOutputs(bound[0], match.outputs);
+
+        if(!agree)
+            ++failures;
+    }
+
+    cout << matches.size() - failures << "/" << matches.size()
+         << " constrained searches agree" << endl;
+
+    delete haystack;
+    delete needle;
+    return failures == 0 ? 0 : 1;
+}
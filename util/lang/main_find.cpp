@@ -4,16 +4,18 @@
 using namespace std;
 
 int main(int argc, char** argv) {
-    if(argc != 3) {
+    bool flat = argc == 4 && string(argv[3]) == "--flat";
+    if(argc != 3 && !flat) {
         cerr << "Bad arguments. Usage:\n" << argv[0]
-             << " [haystack.circ] [needle.circ]" << endl;
+             << " [haystack.circ] [needle.circ] [--flat]" << endl;
         return 1;
     }
 
     CircuitGroup* haystack = parse(argv[1]);
     CircuitGroup* needle = parse(argv[2]);
 
-    vector<MatchResult> matches = haystack->find(needle);
+    vector<MatchResult> matches =
+        flat ? haystack->findFlat(needle) : haystack->find(needle);
 
     cout << matches.size() << " matches" << endl;
 
@@ -0,0 +1,50 @@
+/** Subcircuit search benchmark.
+ *
+ * Searches the given needle in the given haystack a number of times, both
+ * hierarchically (`CircuitGroup::find`) and in the flattened haystack
+ * (`CircuitGroup::findFlat`), and prints the average time spent per search.
+ */
+
+#include <cstdio>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "aux.h"
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double msSince(const Clock::time_point& start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    if(argc != 3 && argc != 4) {
+        cerr << "Bad arguments. Usage:\n" << argv[0]
+             << " [haystack.circ] [needle.circ] [rounds=1000]" << endl;
+        return 1;
+    }
+    int rounds = argc == 4 ? stoi(argv[3]) : 1000;
+
+    CircuitGroup* haystack = parse(argv[1]);
+    CircuitGroup* needle = parse(argv[2]);
+
+    size_t matches = 0;
+    auto start = Clock::now();
+    for(int round = 0; round < rounds; ++round)
+        matches = haystack->find(needle).size();
+    cout << "find:     " << msSince(start) / rounds << " ms, "
+         << matches << " matches" << endl;
+
+    // Flat searches are much slower: run fewer of them
+    int flatRounds = rounds / 50 + 1;
+    start = Clock::now();
+    for(int round = 0; round < flatRounds; ++round)
+        matches = haystack->findFlat(needle).size();
+    cout << "findFlat: " << msSince(start) / flatRounds << " ms, "
+         << matches << " matches" << endl;
+
+    delete haystack;
+    delete needle;
+    return 0;
+}
@@ -0,0 +1,79 @@
+/** Frozen snapshot check and benchmark.
+ *
+ * Freezes the given haystack and needle (see `frozenCircuit.h`), then signs,
+ * compares and searches the snapshots from a number of threads at once, and
+ * prints the time spent in each phase.
+ *
+ * Exits with a non-zero status if any thread disagrees with the results
+ * computed on the original circuits, or if names are left interned once
+ * every circuit is deleted.
+ */
+
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "aux.h"
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double msSince(const Clock::time_point& start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    if(argc != 3 && argc != 4) {
+        cerr << "Bad arguments. Usage:\n" << argv[0]
+             << " [haystack.circ] [needle.circ] [threads=4]" << endl;
+        return 1;
+    }
+    int threadCount = argc == 4 ? stoi(argv[3]) : 4;
+    size_t initialNames = nameInterner::size();
+
+    CircuitGroup* haystack = parse(argv[1]);
+    CircuitGroup* needle = parse(argv[2]);
+    sign_t expectedSig = haystack->sign();
+    size_t expectedMatches = haystack->find(needle).size();
+
+    auto start = Clock::now();
+    FrozenCircuit* frozenHaystack = haystack->freeze();
+    FrozenCircuit* frozenNeedle = needle->freeze();
+    FrozenCircuit* frozenCopy = haystack->freeze();
+    cout << "freeze: " << msSince(start) << " ms" << endl;
+
+    delete haystack; // The snapshots do not depend on the originals
+    delete needle;
+
+    atomic<int> failures(0);
+    vector<thread> threads;
+    start = Clock::now();
+    for(int thr = 0; thr < threadCount; ++thr) {
+        threads.emplace_back([&]() {
+            if(frozenHaystack->sign() != expectedSig
+                    || !frozenHaystack->equals(*frozenCopy)
+                    || frozenHaystack->find(*frozenNeedle).size()
+                        != expectedMatches)
+            {
+                ++failures;
+            }
+        });
+    }
+    for(auto& thr: threads)
+        thr.join();
+    cout << threadCount << " threads: " << msSince(start) << " ms, "
+         << expectedMatches << " matches, "
+         << failures << " failures" << endl;
+
+    delete frozenHaystack;
+    delete frozenNeedle;
+    delete frozenCopy;
+
+    size_t leakedNames = nameInterner::size() - initialNames;
+    if(leakedNames > 0)
+        cerr << leakedNames << " names left interned" << endl;
+    return failures == 0 && leakedNames == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+/** Net index check.
+ *
+ * Flattens the given circuit (see `FlatNetlist`), prints its number of nets
+ * and gates, and checks its net index (see `CircuitGroup::netIndex`): every
+ * wire of the hierarchy, merged or not, must belong to a net, every net must
+ * hold some wire, and a wire created after the index was built must be
+ * reported out of it.
+ *
+ * Exits with a non-zero status if it is not the case.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include "aux.h"
+using namespace std;
+
+int main(int argc, char** argv) {
+    if(argc != 2) {
+        cerr << "Bad arguments. Usage:\n" << argv[0]
+             << " [circuit.circ]" << endl;
+        return 1;
+    }
+
+    CircuitGroup* circuit = parse(argv[1]);
+    bool valid = true;
+    {
+        FlatNetlist flat(circuit);
+        cout << flat.netCount() << " nets, " << flat.gateCount() << " gates"
+             << endl;
+        for(size_t net = 0; net < flat.netCount(); ++net)
+            valid = valid && flat.netWire(net) != nullptr;
+
+        // Every wire, merged ones included, is in the net of its root
+        vector<CircuitGroup*> groups(1, circuit);
+        for(size_t pos = 0; pos < groups.size(); ++pos) {
+            WireManager* manager = groups[pos]->wireManager();
+            for(auto wire: manager->allWires()) {
+                size_t net = flat.netOf(wire);
+                valid = valid && net != NetIndex::NO_NET
+                    && net == flat.netOf(
+                            manager->allWires()[manager->rootOf(wire->id())]);
+            }
+            for(auto child: groups[pos]->getChildrenCst()) {
+                if(child->circType() == CircuitTree::CIRC_GROUP)
+                    groups.push_back(static_cast<CircuitGroup*>(child));
+            }
+        }
+    }
+
+    // Creating a wire does not alter the group: the cached index is kept,
+    // and must not mistake the new wire for another one
+    WireId* fresh = circuit->wireManager()->fresh();
+    valid = valid && circuit->netIndex().netOf(fresh) == NetIndex::NO_NET;
+
+    delete circuit;
+    return valid ? 0 : 1;
+}
@@ -1,5 +1,6 @@
 #include <cstdio>
 #include <iostream>
+#include <vector>
 #include "aux.h"
 using namespace std;
 
@@ -25,8 +26,17 @@ int main(int, char** argv) {
         }
     }
 
+    vector<CircuitTree*> siblings;
+    for(const auto& child: d1->getChildrenCst())
+        if(child != d2)
+            siblings.push_back(child);
+
     d2->unplug();
     delete d2;
+    if(d1->getChildrenCst() != siblings) {
+        cerr << "Unplugging reordered the remaining children" << endl;
+        return 1;
+    }
     d1->addChild(repl);
 
     cout << circuit->sign() << endl;
@@ -0,0 +1,58 @@
+/** Match selection check.
+ *
+ * Searches the given needle in the given haystack, both hierarchically and
+ * flat, with the greedy then the maximum selection of matches (see
+ * `MatchSelection`), and prints the number of matches found each time. The
+ * maximum selection must find pairwise disjoint matches, and at least as
+ * many as the greedy one.
+ *
+ * Exits with a non-zero status if it is not the case.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <set>
+#include "aux.h"
+using namespace std;
+
+/// Checks whether no two of `matches` share a part
+static bool disjoint(const vector<MatchResult>& matches) {
+    set<CircuitTree*> parts;
+    for(const auto& match: matches)
+        for(auto part: match.parts)
+            if(!parts.insert(part).second)
+                return false;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(argc != 3) {
+        cerr << "Bad arguments. Usage:\n" << argv[0]
+             << " [haystack.circ] [needle.circ]" << endl;
+        return 1;
+    }
+
+    CircuitGroup* haystack = parse(argv[1]);
+    CircuitGroup* needle = parse(argv[2]);
+
+    bool agree = true;
+    for(bool flat: {false, true}) {
+        auto find = [&]() {
+            return flat ? haystack->findFlat(needle) : haystack->find(needle);
+        };
+
+        setMatchSelection(MatchSelection::GREEDY);
+        vector<MatchResult> greedy = find();
+        setMatchSelection(MatchSelection::MAXIMUM);
+        vector<MatchResult> maximum = find();
+
+        cout << (flat ? "flat: " : "find: ") << greedy.size() << " greedy, "
+             << maximum.size() << " maximum matches" << endl;
+        agree = agree && disjoint(greedy) && disjoint(maximum)
+            && maximum.size() >= greedy.size();
+    }
+
+    delete haystack;
+    delete needle;
+    return agree ? 0 : 1;
+}
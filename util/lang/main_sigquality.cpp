@@ -0,0 +1,283 @@
+/** Signature quality and speed benchmark.
+ *
+ * Measures the speed of the signature mixing function and of whole-circuit
+ * signing, and counts signature collisions on the given circuit and on
+ * synthetic random designs. Build the library with or without
+ * `SIGN_MIX_XORSHIFT` (or `SIGN_128`) to compare the signature families.
+ *
+ * Exits with a non-zero status if the batched signature kernels disagree with
+ * the scalar mixing function, if two formally different leaf gates of the
+ * circuit share a signature, or if more than the given number of synthetic
+ * expressions per million collide.
+ */
+
+#include <cstdio>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+#include "aux.h"
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/* The synthetic expressions are the same for every build: the thresholds sit
+ * just above the collisions measured on them (none with the xorshift mixing
+ * or 128-bit signatures), so that both families can be compared. */
+#if defined(SIGN_MIX_XORSHIFT) || defined(SIGN_128)
+static const size_t DEFAULT_MAX_COLLISIONS_PPM = 10;
+#else
+/* The 64-bit modular mixing is affine on small hashes (eg. small constants or
+ * input ids), thus eg. `4 - 3` and `2 - 1` collide: 327 of the 125919
+ * synthetic expressions (2597 ppm) do. */
+static const size_t DEFAULT_MAX_COLLISIONS_PPM = 2800;
+#endif
+
+static double msSince(const Clock::time_point& start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/// Collects every circuit of the hierarchy rooted at `circ`
+static void collect(CircuitTree* circ, vector<CircuitTree*>& out) {
+    out.push_back(circ);
+    if(circ->circType() == CircuitTree::CIRC_GROUP) {
+        for(auto child: static_cast<CircuitGroup*>(circ)->getChildrenCst())
+            collect(child, out);
+    }
+}
+
+static size_t distinctSigs(const vector<CircuitTree*>& circs, int level) {
+    unordered_set<sign_t, SignHash> sigs;
+    for(auto circ: circs)
+        sigs.insert(circ->sign(level));
+    return sigs.size();
+}
+
+/** Counts the leaf gates sharing a level-0 signature with a formally
+ * different leaf gate (level-0 signatures of leaves only depend on their
+ * contents, thus these are genuine collisions). */
+static size_t leafCollisions(const vector<CircuitTree*>& circs) {
+    unordered_map<sign_t, vector<CircuitTree*>, SignHash> buckets;
+    for(auto circ: circs) {
+        if(circ->circType() != CircuitTree::CIRC_GROUP)
+            buckets[circ->sign(0)].push_back(circ);
+    }
+
+    size_t collisions = 0;
+    for(const auto& bucket: buckets) {
+        vector<CircuitTree*> classes;
+        for(auto circ: bucket.second) {
+            bool found = false;
+            for(auto repr: classes) {
+                if(repr->equals(circ)) {
+                    found = true;
+                    break;
+                }
+            }
+            if(!found)
+                classes.push_back(circ);
+        }
+        collisions += classes.size() - 1;
+    }
+    return collisions;
+}
+
+static void benchMixing() {
+    const size_t ROUNDS = 10000000;
+    sign_t cur = 1;
+    auto start = Clock::now();
+    for(size_t round = 0; round < ROUNDS; ++round)
+        cur = signatureConstants::opcst_and(cur + round);
+    double elapsed = msSince(start);
+    cout << "mixing: " << (elapsed * 1e6 / ROUNDS) << " ns/call"
+         << " (check " << (cur & 0xff) << ")" << endl;
+}
+
+/** Compares the batched signature kernels (scalar and SIMD), checking that
+ * they agree with `OperConstants` */
+static bool benchBatch() {
+    const size_t COUNT = 1 << 20;
+    const int ROUNDS = 10;
+    mt19937_64 gen(42);
+    vector<sign_t> keys(COUNT), scalar(COUNT), simd(COUNT);
+    for(auto& key: keys)
+        key = gen();
+
+    batchSign::setSimdEnabled(false);
+    auto start = Clock::now();
+    for(int round = 0; round < ROUNDS; ++round)
+        batchSign::mix(signatureConstants::opcst_leaftype,
+                keys.data(), scalar.data(), COUNT);
+    double scalarTime = msSince(start);
+
+    batchSign::setSimdEnabled(true);
+    start = Clock::now();
+    for(int round = 0; round < ROUNDS; ++round)
+        batchSign::mix(signatureConstants::opcst_leaftype,
+                keys.data(), simd.data(), COUNT);
+    double simdTime = msSince(start);
+
+    bool agree = true;
+    for(size_t pos = 0; pos < COUNT; ++pos) {
+        if(scalar[pos] != signatureConstants::opcst_leaftype(keys[pos])
+                || simd[pos] != scalar[pos])
+            agree = false;
+    }
+    cout << "batch: scalar " << (scalarTime * 1e6 / (ROUNDS * COUNT))
+         << " ns/sig, simd" << (batchSign::simdAvailable() ? "" : " (n/a)")
+         << " " << (simdTime * 1e6 / (ROUNDS * COUNT)) << " ns/sig, "
+         << (agree ? "agreeing" : "MISMATCH") << endl;
+    return agree;
+}
+
+/// Returns whether the circuit's leaves are free of collisions
+static bool benchCircuit(CircuitGroup* circuit) {
+    const int ROUNDS = 20;
+    vector<CircuitTree*> circs;
+    collect(circuit, circs);
+
+    auto start = Clock::now();
+    for(int round = 0; round < ROUNDS; ++round) {
+        for(auto circ: circs)
+            circ->alter(false);
+        circuit->sign();
+    }
+    cout << "circuit: " << circs.size() << " circuits, full signature in "
+         << msSince(start) / ROUNDS << " ms" << endl;
+
+    for(int level = 0; level <= 3; ++level) {
+        cout << "  level " << level << ": "
+             << distinctSigs(circs, level) << " distinct signatures" << endl;
+    }
+
+    size_t collisions = leafCollisions(circs);
+    cout << "  leaf collisions: " << collisions << endl;
+    return collisions == 0;
+}
+
+static ExpressionBase* randExpr(mt19937& gen, int depth) {
+    uniform_int_distribution<int> kindDistr(0, depth <= 0 ? 1 : 7);
+    uniform_int_distribution<int> smallDistr(0, 7);
+    switch(kindDistr(gen)) {
+        case 0:
+            return ExpressionVar::make(smallDistr(gen));
+        case 1:
+            return ExpressionConst::make(smallDistr(gen));
+        case 2:
+        case 3:
+        case 4: {
+            uniform_int_distribution<int> opDistr(expr::BAnd, expr::BAsr);
+            expr::ExpressionBinOperator op =
+                (expr::ExpressionBinOperator)opDistr(gen);
+            ExpressionBase* left = randExpr(gen, depth - 1);
+            ExpressionBase* right = randExpr(gen, depth - 1);
+            // Commutative operators are signed as such: canonize them
+            if(op <= expr::BAdd || op == expr::BMul) {
+                if(right->sign() < left->sign())
+                    swap(left, right);
+            }
+            // The others are signed from `left - right`: `x op x` is
+            // signed the same for every `x`
+            else if(left == right)
+                return left;
+            return ExpressionBinOp::make(left, right, op);
+        }
+        case 5:
+            return ExpressionUnOp::make(randExpr(gen, depth - 1), expr::UNot);
+        case 6:
+            return ExpressionUnOpCst::make(randExpr(gen, depth - 1),
+                    smallDistr(gen), expr::UCLsl);
+        default: {
+            unsigned beg = smallDistr(gen);
+            return ExpressionSlice::make(randExpr(gen, depth - 1),
+                    beg, beg + 1 + smallDistr(gen));
+        }
+    }
+}
+
+/** Counts the collisions among the signatures of random, formally distinct,
+ * expressions, and returns whether there are at most `maxPpm` per million */
+static bool syntheticExprCollisions(size_t maxPpm) {
+    const size_t COUNT = 200000;
+    mt19937 gen(42);
+
+    vector<ExpressionBase*> exprs;
+    unordered_set<ExpressionBase*> distinct;
+    for(size_t pos = 0; pos < COUNT; ++pos) {
+        ExpressionBase* cur = randExpr(gen, 5);
+        cur->addRef();
+        exprs.push_back(cur);
+        distinct.insert(cur);
+    }
+
+    unordered_set<sign_t, SignHash> sigs;
+    for(auto expr: distinct)
+        sigs.insert(expr->sign());
+    size_t collisions = distinct.size() - sigs.size();
+    cout << "synthetic expressions: " << distinct.size()
+         << " distinct, " << collisions << " collisions (at most "
+         << maxPpm * distinct.size() / 1000000 << " allowed)" << endl;
+
+    for(auto expr: exprs)
+        expr->deleteSelf();
+    return collisions * 1000000 <= maxPpm * distinct.size();
+}
+
+/** Signs a random flat design of 2-input comb gates */
+static void syntheticDesign() {
+    const size_t GATES = 50000, WIRES = 20000;
+    mt19937 gen(1337);
+    uniform_int_distribution<size_t> wireDistr(0, WIRES - 1);
+    uniform_int_distribution<int> opDistr(expr::BAnd, expr::BXor);
+
+    CircuitGroup* design = new CircuitGroup("synthetic");
+    WireManager* manager = design->wireManager();
+    for(size_t gate = 0; gate < GATES; ++gate) {
+        CircuitComb* comb = new CircuitComb();
+        comb->addInput(manager->wire(to_string(wireDistr(gen))));
+        comb->addInput(manager->wire(to_string(wireDistr(gen))));
+        comb->addOutput(ExpressionBinOp::make(
+                    ExpressionVar::make(0), ExpressionVar::make(1),
+                    (expr::ExpressionBinOperator)opDistr(gen)),
+                manager->wire(to_string(wireDistr(gen))));
+        design->addChild(comb);
+    }
+
+    vector<CircuitTree*> circs;
+    collect(design, circs);
+    auto start = Clock::now();
+    design->sign();
+    cout << "synthetic design: " << GATES << " gates, signed in "
+         << msSince(start) << " ms" << endl;
+    for(int level = 0; level <= 3; ++level) {
+        cout << "  level " << level << ": "
+             << distinctSigs(circs, level) << " distinct signatures" << endl;
+    }
+
+    delete design;
+}
+
+int main(int argc, char** argv) {
+    if(argc != 2 && argc != 3) {
+        cerr << "Bad arguments. Usage:\n" << argv[0]
+             << " [circuit.circ] [max collisions per million="
+             << DEFAULT_MAX_COLLISIONS_PPM << "]" << endl;
+        return 1;
+    }
+    size_t maxPpm = argc == 3 ? stoul(argv[2]) : DEFAULT_MAX_COLLISIONS_PPM;
+
+    benchMixing();
+    bool batchOk = benchBatch();
+
+    CircuitGroup* circuit = parse(argv[1]);
+    bool leavesOk = benchCircuit(circuit);
+    delete circuit;
+
+    bool exprsOk = syntheticExprCollisions(maxPpm);
+    syntheticDesign();
+
+    return batchOk && leavesOk && exprsOk ? 0 : 1;
+}
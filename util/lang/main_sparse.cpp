@@ -0,0 +1,92 @@
+/** Sparse matrices and anchored search benchmark.
+ *
+ * Replicates the given haystack a number of times (1, 2, 4, … up to the
+ * given count) as the children of a single group, then searches the needle
+ * in the flattened result, on the whole group with dense bit matrices, then
+ * with compressed bitsets (see `setMatchMatrices`), and finally around
+ * anchors (see `setMatchStrategy`). Prints the time spent by each at each
+ * scale.
+ *
+ * Exits with a non-zero status if they disagree on the number of matches.
+ */
+
+#include <cstdio>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "aux.h"
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double msSince(const Clock::time_point& start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/// Builds a group holding `copies` copies of the circuit at `path`
+static CircuitGroup* replicate(const char* path, int copies) {
+    CircuitGroup* root = new CircuitGroup("replicated");
+    for(int copy = 0; copy < copies; ++copy) {
+        CircuitGroup* circ = parse(path);
+        for(auto pin: circ->getInputs())
+            pin->connect(root->wireManager()->fresh());
+        for(auto pin: circ->getOutputs())
+            pin->connect(root->wireManager()->fresh());
+        root->addChild(circ);
+    }
+    return root;
+}
+
+/** Searches `needle` in `flat` with `matrices` and `strategy`, printing the
+ * time spent */
+static size_t bench(FlatNetlist& flat, CircuitGroup* needle,
+        MatchMatrices matrices, MatchStrategy strategy, const char* label)
+{
+    setMatchMatrices(matrices);
+    setMatchStrategy(strategy);
+    auto start = Clock::now();
+    size_t matches = flat.find(needle).size();
+    cout << "  " << label << ": " << msSince(start) << " ms, " << matches
+         << " matches" << endl;
+    return matches;
+}
+
+int main(int argc, char** argv) {
+    if(argc != 3 && argc != 4) {
+        cerr << "Bad arguments. Usage:\n" << argv[0]
+             << " [haystack.circ] [needle.circ] [maxCopies=4]" << endl;
+        return 1;
+    }
+    int maxCopies = argc == 4 ? stoi(argv[3]) : 4;
+
+    CircuitGroup* needle = parse(argv[2]);
+    bool agree = true;
+    for(int copies = 1; copies <= maxCopies; copies *= 2) {
+        CircuitGroup* haystack = replicate(argv[1], copies);
+        {
+            FlatNetlist flat(haystack);
+            cout << copies << " copies (" << flat.gateCount() << " gates, "
+                 << flat.netCount() << " nets):" << endl;
+
+            size_t dense = bench(flat, needle, MatchMatrices::DENSE,
+                    MatchStrategy::WHOLE_GROUP, "dense   ");
+            size_t sparse = bench(flat, needle, MatchMatrices::SPARSE,
+                    MatchStrategy::WHOLE_GROUP, "sparse  ");
+            size_t anchored = bench(flat, needle, MatchMatrices::AUTO,
+                    MatchStrategy::ANCHORED, "anchored");
+            if(dense != sparse || dense != anchored)
+                agree = false;
+        }
+        delete haystack;
+    }
+    setMatchMatrices(MatchMatrices::AUTO);
+    setMatchStrategy(MatchStrategy::AUTO);
+    delete needle;
+
+    if(!agree) {
+        cerr << "The dense, sparse and anchored searches disagree" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -23,9 +23,7 @@ using namespace parseTools;
 vector<WireManager*> wireManagers;
 
 WireId* nextWire() {
-    static int curId = 0;
-    return wireManagers.back()->fresh(
-        std::string(" _wire_") + std::to_string(curId++));
+    return wireManagers.back()->fresh();
 }
 
 void yyerror(const char *error)
@@ -139,7 +137,7 @@ stmtList:
 stmt:
     IDENT '=' expr      {
                             wireManagers.back()->rename(
-                                $3.outWire->name(), $1);
+                                $3.outWire->id(), $1);
                             $$ = $3.gates;
                             free($1);
                         }
@@ -155,9 +153,9 @@ expr:
                             comb->addInput(left);
                             comb->addInput(right);
                             comb->addOutput(
-                                new ExpressionBinOp(
-                                    new ExpressionVar(0),
-                                    new ExpressionVar(1),
+                                ExpressionBinOp::make(
+                                    ExpressionVar::make(0),
+                                    ExpressionVar::make(1),
                                     $1),
                                 outWire);
 
@@ -173,8 +171,8 @@ expr:
                             CircuitComb* comb = new CircuitComb();
                             comb->addInput(from);
                             comb->addOutput(
-                                new ExpressionUnOp(
-                                    new ExpressionVar(0),
+                                ExpressionUnOp::make(
+                                    ExpressionVar::make(0),
                                     $1),
                                 outWire);
 
@@ -188,8 +186,8 @@ expr:
                             CircuitComb* comb = new CircuitComb();
                             comb->addInput(from);
                             comb->addOutput(
-                                new ExpressionUnOpCst(
-                                    new ExpressionVar(0),
+                                ExpressionUnOpCst::make(
+                                    ExpressionVar::make(0),
                                     $3,
                                     $1),
                                 outWire);
@@ -206,9 +204,9 @@ expr:
                             merger->addInput(left);
                             merger->addInput(right);
                             merger->addOutput(
-                                new ExpressionMerge(
-                                    new ExpressionVar(0),
-                                    new ExpressionVar(1)),
+                                ExpressionMerge::make(
+                                    ExpressionVar::make(0),
+                                    ExpressionVar::make(1)),
                                 outWire);
                             $$ = ExprConstruction(
                                 outWire,
@@ -220,8 +218,8 @@ expr:
                             CircuitComb* slicer = new CircuitComb();
                             slicer->addInput(from);
                             slicer->addOutput(
-                                new ExpressionSlice(
-                                    new ExpressionVar(0), $3, $4),
+                                ExpressionSlice::make(
+                                    ExpressionVar::make(0), $3, $4),
                                 outWire);
                             $$ = ExprConstruction(
                                 outWire,
@@ -257,7 +255,7 @@ expr:
   | NUMBER              {
                             WireId* outWire = nextWire();
                             CircuitComb* out = new CircuitComb();
-                            out->addOutput(new ExpressionConst($1), outWire);
+                            out->addOutput(ExpressionConst::make($1), outWire);
                             $$ = ExprConstruction(outWire, out);
                         }
 
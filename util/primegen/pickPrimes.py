@@ -2,6 +2,7 @@
 
 from genprime import gen_one as gen_one_prime
 from random import randint
+import sys
 
 # CONSTANTS
 operations = [
@@ -29,18 +30,48 @@ operations = [
     'slicebounds',
     'leaftype',
     'groupIO',
+    'highhalf',
 ]
 
 PRIME_MAGNITUDE = 10**8
 
 
-print("// ==== CONSTANTS ==== (Auto-generated)")
-print("// ===================")
-for op in operations:
-    print("const OperConstants opcst_{}({}u, {}u, {}u, {}u, {}u);".format(
-        op,
-        randint(1 << 16, 1 << 32),
-        gen_one_prime(PRIME_MAGNITUDE),
-        gen_one_prime(PRIME_MAGNITUDE),
-        gen_one_prime(PRIME_MAGNITUDE),
-        gen_one_prime(PRIME_MAGNITUDE)))
+def gen_multiplier():
+    """ Random odd 64-bit multiplier with a balanced number of set bits, as
+    used by the multiply-xorshift mixing family """
+    while True:
+        mul = randint(1 << 63, (1 << 64) - 1) | 1
+        if 28 <= bin(mul).count('1') <= 36:
+            return mul
+
+
+def print_modulo_constants():
+    print("// ==== CONSTANTS ==== (Auto-generated)")
+    print("// ===================")
+    for op in operations:
+        print("const OperConstants opcst_{}({}u, {}u, {}u, {}u, {}u);".format(
+            op,
+            randint(1 << 16, 1 << 32),
+            gen_one_prime(PRIME_MAGNITUDE),
+            gen_one_prime(PRIME_MAGNITUDE),
+            gen_one_prime(PRIME_MAGNITUDE),
+            gen_one_prime(PRIME_MAGNITUDE)))
+
+
+def print_xorshift_constants():
+    print("// ==== CONSTANTS ==== (Auto-generated, multiply-xorshift)")
+    print("// ===================")
+    for op in operations:
+        print("const OperConstants opcst_{}(0x{:016x}ull, 0x{:016x}ull, "
+              "0x{:016x}ull);".format(
+                  op,
+                  randint(1 << 32, (1 << 64) - 1),
+                  gen_multiplier(),
+                  gen_multiplier()))
+
+
+if __name__ == '__main__':
+    if '--xorshift' in sys.argv[1:]:
+        print_xorshift_constants()
+    else:
+        print_modulo_constants()
@@ -100,28 +100,28 @@ namespace {
     }
 
     ExpressionVar* scrambleExpressionVar(const ExpressionVar* expr) {
-        return new ExpressionVar(expr->id);
+        return ExpressionVar::make(expr->id);
     }
 
     ExpressionConst* scrambleExpressionConst(const ExpressionConst* expr) {
-        return new ExpressionConst(expr->val);
+        return ExpressionConst::make(expr->val);
     }
 
     ExpressionLongConst* scrambleExpressionLongConst(
             const ExpressionLongConst* expr)
     {
-        return new ExpressionLongConst(expr->val);
+        return ExpressionLongConst::make(expr->val);
     }
 
     ExpressionBinOp* scrambleExpressionBinOp(const ExpressionBinOp* expr) {
-        return new ExpressionBinOp(
+        return ExpressionBinOp::make(
                 scrambleExpression(expr->left),
                 scrambleExpression(expr->right),
                 expr->op);
     }
 
     ExpressionUnOp* scrambleExpressionUnOp(const ExpressionUnOp* expr) {
-        return new ExpressionUnOp(
+        return ExpressionUnOp::make(
                 scrambleExpression(expr->expr),
                 expr->op);
     }
@@ -129,21 +129,21 @@ namespace {
     ExpressionUnOpCst* scrambleExpressionUnOpCst(
             const ExpressionUnOpCst* expr)
     {
-        return new ExpressionUnOpCst(
+        return ExpressionUnOpCst::make(
                 scrambleExpression(expr->expr),
                 expr->val,
                 expr->op);
     }
 
     ExpressionSlice* scrambleExpressionSlice(const ExpressionSlice* expr) {
-        return new ExpressionSlice(
+        return ExpressionSlice::make(
                 scrambleExpression(expr->expr),
                 expr->beg,
                 expr->end);
     }
 
     ExpressionMerge* scrambleExpressionMerge(const ExpressionMerge* expr) {
-        return new ExpressionMerge(
+        return ExpressionMerge::make(
                 scrambleExpression(expr->left),
                 scrambleExpression(expr->right));
     }